@@ -0,0 +1,398 @@
+#ifndef MGKTL_MCONTAINERS_CONCURRENTQUEUE_HPP
+#define MGKTL_MCONTAINERS_CONCURRENTQUEUE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <MData/Allocator.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MGK_QUEUE_PAUSE() _mm_pause()
+#else
+#define MGK_QUEUE_PAUSE() std::this_thread::yield()
+#endif
+
+namespace mgk {
+
+namespace detail {
+
+    inline constexpr size_t QUEUE_LINE_SZ = 64;
+
+    /// Counter alone on its cache line, so writes to it do not invalidate neighbouring data of other threads.
+    struct alignas(QUEUE_LINE_SZ) PaddedCounter
+    {
+        std::atomic<size_t> value = 0;
+    };
+
+    /// Spins a little, then gives up time slice, for waits which are normally short.
+    inline void backoff(size_t& spins)
+    {
+        if(++spins < 64) MGK_QUEUE_PAUSE();
+        else             std::this_thread::yield();
+    }
+
+}
+
+/**
+ * @brief Bounded lock-free queue for one producer thread and one consumer thread.
+ *
+ * Producer owns tail, consumer owns head, each on its own cache line. Each side also keeps cached copy of the
+ * other's counter and reloads it only when queue looks full or empty, so usually no line moves between cores.
+ * Batch operations publish whole batch with one store.
+ */
+template<class T, template<class> class Alloc = DefaultDynamicAllocator>
+requires std::is_nothrow_move_constructible_v<T> && std::is_nothrow_destructible_v<T>
+class SpscQueue
+{
+public:
+    enum class Error
+    {
+        OutOfMemory,
+    };
+
+    using value_type = T;
+
+    /// Capacity is rounded up to power of two.
+    explicit SpscQueue(size_t capacity, const Alloc<T>& alloc = Alloc<T>())
+        : head_(), tail_(), capacity_(std::bit_ceil(std::max<size_t>(capacity, 2))), mask_(capacity_ - 1), alloc_(alloc)
+    {
+        slots_ = alloc_.allocate(capacity_);
+        if(!slots_) throw Error::OutOfMemory;
+    }
+
+    SpscQueue(const SpscQueue&)            = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    ~SpscQueue()
+    {
+        size_t tail = tail_.value.load(std::memory_order_relaxed);
+        for(size_t i = head_.value.load(std::memory_order_relaxed); i != tail; ++i) slots_[i & mask_].~T();
+        alloc_.deallocate(slots_, capacity_);
+    }
+
+    size_t capacity() const { return capacity_; }
+
+    /// Exact only when neither side runs.
+    size_t size() const
+    {
+        // Head is read first: tail only grows, so it is not behind head read before it.
+        size_t head = head_.value.load(std::memory_order_acquire);
+        return tail_.value.load(std::memory_order_acquire) - head;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    /// Producer only.
+    template<class... Args>
+    bool try_emplace(Args&&... args)
+    {
+        size_t tail = tail_.value.load(std::memory_order_relaxed);
+        if(tail - producerHead_ == capacity_)
+        {
+            producerHead_ = head_.value.load(std::memory_order_acquire);
+            if(tail - producerHead_ == capacity_) return false;
+        }
+        new(&slots_[tail & mask_]) T(std::forward<Args>(args)...);
+        tail_.value.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_push(const T& value) { return try_emplace(value); }
+    bool try_push(T&& value)      { return try_emplace(std::move(value)); }
+
+    /// Consumer only.
+    bool try_pop(T& value)
+    {
+        size_t head = head_.value.load(std::memory_order_relaxed);
+        if(head == consumerTail_)
+        {
+            consumerTail_ = tail_.value.load(std::memory_order_acquire);
+            if(head == consumerTail_) return false;
+        }
+        T& slot = slots_[head & mask_];
+        value = std::move(slot);
+        slot.~T();
+        head_.value.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Moves up to n elements from first into queue, producer only. Returns number of pushed elements.
+     */
+    template<std::input_iterator Iter>
+    size_t try_push_n(Iter first, size_t n)
+    {
+        size_t tail = tail_.value.load(std::memory_order_relaxed);
+        if(capacity_ - (tail - producerHead_) < n) producerHead_ = head_.value.load(std::memory_order_acquire);
+
+        size_t count = std::min(n, capacity_ - (tail - producerHead_));
+        for(size_t i = 0; i < count; ++i, ++first) new(&slots_[(tail + i) & mask_]) T(std::move(*first));
+        if(count) tail_.value.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    /**
+     * @brief Moves up to n elements from queue to dst, consumer only. Returns number of popped elements.
+     */
+    template<std::output_iterator<T> Iter>
+    size_t try_pop_n(Iter dst, size_t n)
+    {
+        size_t head = head_.value.load(std::memory_order_relaxed);
+        if(consumerTail_ - head < n) consumerTail_ = tail_.value.load(std::memory_order_acquire);
+
+        size_t count = std::min(n, consumerTail_ - head);
+        for(size_t i = 0; i < count; ++i, ++dst)
+        {
+            T& slot = slots_[(head + i) & mask_];
+            *dst = std::move(slot);
+            slot.~T();
+        }
+        if(count) head_.value.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    /// Waits while queue is full.
+    void push(T value)
+    {
+        for(size_t spins = 0; !try_push(std::move(value));) detail::backoff(spins);
+    }
+
+    /// Waits while queue is empty.
+    void pop(T& value)
+    {
+        for(size_t spins = 0; !try_pop(value);) detail::backoff(spins);
+    }
+
+private:
+    detail::PaddedCounter head_;
+    alignas(detail::QUEUE_LINE_SZ) size_t consumerTail_ = 0; ///< Tail as consumer saw it last time.
+
+    detail::PaddedCounter tail_;
+    alignas(detail::QUEUE_LINE_SZ) size_t producerHead_ = 0; ///< Head as producer saw it last time.
+
+    alignas(detail::QUEUE_LINE_SZ) T* slots_ = nullptr;
+    size_t   capacity_;
+    size_t   mask_;
+    Alloc<T> alloc_;
+};
+
+/**
+ * @brief Bounded lock-free queue for any number of producers and consumers (Vyukov's queue).
+ *
+ * Every slot has sequence number telling whose turn it is: position p is free for producer of p when sequence
+ * is p and holds value for consumer of p when it is p + 1. Producers and consumers claim positions with CAS
+ * on their padded counter and never touch the other side's counter in single operations.
+ *
+ * Batch operations claim whole range with one CAS and then wait for slots still being written or read by
+ * threads which claimed them earlier. That wait is short unless such thread is preempted.
+ */
+template<class T, template<class> class Alloc = DefaultDynamicAllocator>
+requires std::is_nothrow_move_constructible_v<T> && std::is_nothrow_destructible_v<T>
+class MpmcQueue
+{
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* value() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+public:
+    enum class Error
+    {
+        OutOfMemory,
+    };
+
+    using value_type = T;
+    using slot_type  = Slot;
+
+    /// Capacity is rounded up to power of two.
+    explicit MpmcQueue(size_t capacity, const Alloc<Slot>& alloc = Alloc<Slot>())
+        : head_(), tail_(), capacity_(std::bit_ceil(std::max<size_t>(capacity, 2))), mask_(capacity_ - 1), alloc_(alloc)
+    {
+        slots_ = alloc_.allocate(capacity_);
+        if(!slots_) throw Error::OutOfMemory;
+        for(size_t i = 0; i < capacity_; ++i) new(&slots_[i].sequence) std::atomic<size_t>(i);
+    }
+
+    MpmcQueue(const MpmcQueue&)            = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    ~MpmcQueue()
+    {
+        size_t tail = tail_.value.load(std::memory_order_relaxed);
+        for(size_t i = head_.value.load(std::memory_order_relaxed); i != tail; ++i) slots_[i & mask_].value()->~T();
+        alloc_.deallocate(slots_, capacity_);
+    }
+
+    size_t capacity() const { return capacity_; }
+
+    /// Exact only when no thread pushes or pops.
+    size_t size() const
+    {
+        size_t head = head_.value.load(std::memory_order_acquire);
+        size_t tail = tail_.value.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    /**
+     * @brief Constructs element at tail unless queue is full. If T cannot be constructed from args without
+     * throwing, it is constructed before position is claimed, so exception leaves queue untouched.
+     */
+    template<class... Args>
+    bool try_emplace(Args&&... args)
+    {
+        if constexpr (!std::is_nothrow_constructible_v<T, Args&&...>)
+        {
+            return try_emplace(T(std::forward<Args>(args)...));
+        }
+        else
+        {
+            Slot* slot = claim_(tail_, 0);
+            if(!slot) return false;
+
+            size_t position = slot->sequence.load(std::memory_order_relaxed);
+            new(slot->storage) T(std::forward<Args>(args)...);
+            slot->sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+    }
+
+    bool try_push(const T& value) { return try_emplace(value); }
+    bool try_push(T&& value)      { return try_emplace(std::move(value)); }
+
+    bool try_pop(T& value)
+    {
+        Slot* slot = claim_(head_, 1);
+        if(!slot) return false;
+
+        size_t position = slot->sequence.load(std::memory_order_relaxed) - 1;
+        value = std::move(*slot->value());
+        slot->value()->~T();
+        slot->sequence.store(position + capacity_, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Moves up to n elements from first into queue. Returns number of pushed elements.
+     */
+    template<std::input_iterator Iter>
+    size_t try_push_n(Iter first, size_t n)
+    {
+        size_t tail  = tail_.value.load(std::memory_order_relaxed);
+        size_t count = 0;
+        do
+        {
+            // Positions below head + capacity were freed or are being freed by consumers which claimed them.
+            size_t head = head_.value.load(std::memory_order_acquire);
+            count = std::min(n, capacity_ - std::min(capacity_, tail - std::min(tail, head)));
+            if(count == 0) return 0;
+        } while(!tail_.value.compare_exchange_weak(tail, tail + count, std::memory_order_relaxed));
+
+        for(size_t i = 0; i < count; ++i, ++first)
+        {
+            Slot& slot = slots_[(tail + i) & mask_];
+            waitFor_(slot, tail + i);
+            new(slot.storage) T(std::move(*first));
+            slot.sequence.store(tail + i + 1, std::memory_order_release);
+        }
+        return count;
+    }
+
+    /**
+     * @brief Moves up to n elements from queue to dst. Returns number of popped elements.
+     */
+    template<std::output_iterator<T> Iter>
+    size_t try_pop_n(Iter dst, size_t n)
+    {
+        size_t head  = head_.value.load(std::memory_order_relaxed);
+        size_t count = 0;
+        do
+        {
+            // Positions below tail were filled or are being filled by producers which claimed them.
+            size_t tail = tail_.value.load(std::memory_order_acquire);
+            count = std::min(n, tail - std::min(tail, head));
+            if(count == 0) return 0;
+        } while(!head_.value.compare_exchange_weak(head, head + count, std::memory_order_relaxed));
+
+        for(size_t i = 0; i < count; ++i, ++dst)
+        {
+            Slot& slot = slots_[(head + i) & mask_];
+            waitFor_(slot, head + i + 1);
+            *dst = std::move(*slot.value());
+            slot.value()->~T();
+            slot.sequence.store(head + i + capacity_, std::memory_order_release);
+        }
+        return count;
+    }
+
+    /// Waits while queue is full.
+    void push(T value)
+    {
+        for(size_t spins = 0; !try_push(std::move(value));) detail::backoff(spins);
+    }
+
+    /// Waits while queue is empty.
+    void pop(T& value)
+    {
+        for(size_t spins = 0; !try_pop(value);) detail::backoff(spins);
+    }
+
+private:
+    detail::PaddedCounter head_;
+    detail::PaddedCounter tail_;
+
+    alignas(detail::QUEUE_LINE_SZ) Slot* slots_ = nullptr;
+    size_t      capacity_;
+    size_t      mask_;
+    Alloc<Slot> alloc_;
+
+    /**
+     * @brief Claims next position of counter if its slot is ready, that is slot sequence is position + lag.
+     * Returns slot or nullptr when queue is full for producers or empty for consumers.
+     */
+    Slot* claim_(detail::PaddedCounter& counter, size_t lag)
+    {
+        size_t position = counter.value.load(std::memory_order_relaxed);
+        while(true)
+        {
+            Slot& slot     = slots_[position & mask_];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            auto   diff     = static_cast<std::ptrdiff_t>(sequence - (position + lag));
+            if(diff == 0)
+            {
+                if(counter.value.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) return &slot;
+            }
+            else if(diff < 0)
+            {
+                return nullptr;
+            }
+            else
+            {
+                position = counter.value.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    static void waitFor_(const Slot& slot, size_t sequence)
+    {
+        for(size_t spins = 0; slot.sequence.load(std::memory_order_acquire) != sequence;) detail::backoff(spins);
+    }
+};
+
+}
+
+#undef MGK_QUEUE_PAUSE
+
+#endif /* MGKTL_MCONTAINERS_CONCURRENTQUEUE_HPP */
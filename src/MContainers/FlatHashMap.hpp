@@ -0,0 +1,665 @@
+#ifndef MGKTL_MCONTAINERS_FLATHASHMAP_HPP
+#define MGKTL_MCONTAINERS_FLATHASHMAP_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <MUtils/utils.hpp>
+#include <MData/Allocator.hpp>
+
+namespace mgk {
+
+namespace detail {
+
+    /// Control byte of free slot has sign bit set. Full slot keeps low 7 bits of key hash there.
+    inline constexpr int8_t CTRL_EMPTY   = -128;
+    inline constexpr int8_t CTRL_DELETED = -2;
+
+    /**
+     * @brief Control bytes of WIDTH neighbouring slots, compared all at once. Every match returns bit mask,
+     * bit i stands for slot i of group.
+     */
+    class CtrlGroup
+    {
+    public:
+#if defined(__AVX2__)
+        static constexpr size_t WIDTH = 32;
+
+        explicit CtrlGroup(const int8_t* ctrl) : ctrl_(_mm256_load_si256(reinterpret_cast<const __m256i*>(ctrl))) {}
+
+        uint32_t match(int8_t h2) const
+        {
+            return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(ctrl_, _mm256_set1_epi8(h2))));
+        }
+
+        uint32_t matchEmpty() const { return match(CTRL_EMPTY); }
+        uint32_t matchFree()  const { return static_cast<uint32_t>(_mm256_movemask_epi8(ctrl_)); }
+
+    private:
+        __m256i ctrl_;
+#elif defined(__SSE2__)
+        static constexpr size_t WIDTH = 16;
+
+        explicit CtrlGroup(const int8_t* ctrl) : ctrl_(_mm_load_si128(reinterpret_cast<const __m128i*>(ctrl))) {}
+
+        uint32_t match(int8_t h2) const
+        {
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl_, _mm_set1_epi8(h2))));
+        }
+
+        uint32_t matchEmpty() const { return match(CTRL_EMPTY); }
+        uint32_t matchFree()  const { return static_cast<uint32_t>(_mm_movemask_epi8(ctrl_)); }
+
+    private:
+        __m128i ctrl_;
+#else
+        static constexpr size_t WIDTH = 16;
+
+        explicit CtrlGroup(const int8_t* ctrl) { std::memcpy(ctrl_, ctrl, WIDTH); }
+
+        uint32_t match(int8_t h2) const
+        {
+            uint32_t mask = 0;
+            for(size_t i = 0; i < WIDTH; ++i) mask |= uint32_t(ctrl_[i] == h2) << i;
+            return mask;
+        }
+
+        uint32_t matchEmpty() const { return match(CTRL_EMPTY); }
+
+        uint32_t matchFree() const
+        {
+            uint32_t mask = 0;
+            for(size_t i = 0; i < WIDTH; ++i) mask |= uint32_t(ctrl_[i] < 0) << i;
+            return mask;
+        }
+
+    private:
+        int8_t ctrl_[WIDTH];
+#endif
+
+    public:
+        static constexpr uint32_t ALL = WIDTH == 32 ? ~uint32_t(0) : (uint32_t(1) << WIDTH) - 1;
+
+        uint32_t matchFull() const { return ~matchFree() & ALL; }
+    };
+
+    template<class K>
+    struct SetPolicy
+    {
+        using key_type  = K;
+        using slot_type = K;
+
+        static constexpr bool CONST_SLOTS = true;
+
+        static const K& key(const slot_type& slot) { return slot; }
+    };
+
+    template<class K, class V>
+    struct MapPolicy
+    {
+        using key_type  = K;
+        using slot_type = std::pair<const K, V>;
+
+        static constexpr bool CONST_SLOTS = false;
+
+        static const K& key(const slot_type& slot) { return slot.first; }
+    };
+
+    /**
+     * @brief Open addressing table in Swiss table layout: slots in one array, one control byte per slot in other.
+     * Lookup compares control bytes of whole group with 7 bits of hash and checks keys only where they match.
+     *
+     * Groups are aligned, probing jumps over groups in triangular order and stops at group with empty slot.
+     * Erased slot becomes tombstone unless its group has empty slot, which no probe can pass anyway.
+     */
+    template<class Policy, class Hash, class Eq, template<class> class Alloc>
+    class FlatHashTable
+    {
+        template<bool CONST>
+        class Iterator;
+
+    public:
+        enum class Error
+        {
+            OutOfRange,
+            OutOfMemory,
+            BadObject,
+            DifferentContainerIterator,
+        };
+
+        using key_type   = typename Policy::key_type;
+        using value_type = typename Policy::slot_type;
+        using hasher     = Hash;
+        using key_equal  = Eq;
+
+        using iterator       = Iterator<false>;
+        using const_iterator = Iterator<true>;
+
+        static constexpr size_t GROUP_WIDTH = CtrlGroup::WIDTH;
+
+        FlatHashTable() = default;
+
+        explicit FlatHashTable(const Alloc<value_type>& alloc) : slotAlloc_(alloc), ctrlAlloc_(rebind_(alloc)) {}
+
+        FlatHashTable(const FlatHashTable& oth)
+            : hash_(oth.hash_), eq_(oth.eq_), slotAlloc_(oth.slotAlloc_), ctrlAlloc_(oth.ctrlAlloc_)
+        {
+            copyFrom_(oth);
+        }
+
+        FlatHashTable& operator=(const FlatHashTable& oth)
+        {
+            if(this == &oth) return *this;
+
+            clean();
+            copyFrom_(oth);
+            return *this;
+        }
+
+        FlatHashTable(FlatHashTable&& oth) : slotAlloc_(oth.slotAlloc_), ctrlAlloc_(oth.ctrlAlloc_)
+        {
+            swap(oth);
+        }
+
+        FlatHashTable& operator=(FlatHashTable&& oth)
+        {
+            swap(oth);
+            return *this;
+        }
+
+        ~FlatHashTable()
+        {
+            destroySlots_();
+            release_(rawCtrl_, slots_, capacity_);
+        }
+
+        void swap(FlatHashTable& other)
+        {
+            std::swap(rawCtrl_   , other.rawCtrl_);
+            std::swap(ctrl_      , other.ctrl_);
+            std::swap(slots_     , other.slots_);
+            std::swap(capacity_  , other.capacity_);
+            std::swap(size_      , other.size_);
+            std::swap(growthLeft_, other.growthLeft_);
+            std::swap(hash_      , other.hash_);
+            std::swap(eq_        , other.eq_);
+            std::swap(slotAlloc_ , other.slotAlloc_);
+            std::swap(ctrlAlloc_ , other.ctrlAlloc_);
+        }
+
+        size_t size()     const { return size_; }
+        size_t capacity() const { return capacity_; }
+        bool   empty()    const { return size_ == 0; }
+
+        bool validate() const noexcept(true)
+        {
+            bool allocated = std::has_single_bit(capacity_) && capacity_ >= GROUP_WIDTH && ctrl_ && slots_;
+            return size_ + growthLeft_ <= maxLoad_(capacity_) && (capacity_ == 0 || allocated);
+        }
+
+        void validateThrow() const noexcept(false)
+        {
+            if(!validate()) throw Error::BadObject;
+        }
+
+        iterator       find(const key_type& key)       { return iterator(this, findIndex_(key, hashOf_(key))); }
+        const_iterator find(const key_type& key) const { return const_iterator(this, findIndex_(key, hashOf_(key))); }
+
+        bool   contains(const key_type& key) const { return findIndex_(key, hashOf_(key)) != capacity_; }
+        size_t count(const key_type& key)    const { return contains(key) ? 1 : 0; }
+
+        /**
+         * @brief Inserts value unless its key is present. Returns position of key and whether value was inserted.
+         */
+        std::pair<iterator, bool> insert(const value_type& value) { return emplaceSlot_(Policy::key(value), value); }
+        std::pair<iterator, bool> insert(value_type&& value)      { return emplaceSlot_(Policy::key(value), std::move(value)); }
+
+        size_t erase(const key_type& key)
+        {
+            size_t index = findIndex_(key, hashOf_(key));
+            if(index == capacity_) return 0;
+
+            eraseAt_(index);
+            return 1;
+        }
+
+        /// Returns iterator to next element.
+        iterator erase(const_iterator pos)
+        {
+            if(pos.table_ != this) throw Error::DifferentContainerIterator;
+            if(pos.index_ >= capacity_) throw Error::OutOfRange;
+
+            eraseAt_(pos.index_);
+            return iterator(this, nextFull_(pos.index_ + 1));
+        }
+
+        /// Destroys elements and drops tombstones, memory stays.
+        void clean()
+        {
+            destroySlots_();
+            if(capacity_) std::memset(ctrl_, CTRL_EMPTY, capacity_);
+            size_       = 0;
+            growthLeft_ = maxLoad_(capacity_);
+        }
+
+        /**
+         * @brief Makes room for n elements, so inserting them does not rehash.
+         */
+        void reserve(size_t n)
+        {
+            if(n <= size_ + growthLeft_) return;
+            rehash_(capacityFor_(n));
+        }
+
+        /// Rehashes to smallest capacity holding present elements, which also drops tombstones.
+        void shrink_to_fit()
+        {
+            size_t capacity = size_ ? capacityFor_(size_) : 0;
+            if(capacity == capacity_ && size_ + growthLeft_ == maxLoad_(capacity_)) return;
+            rehash_(capacity);
+        }
+
+        iterator begin() { return iterator(this, nextFull_(0)); }
+        iterator end()   { return iterator(this, capacity_); }
+
+        const_iterator begin() const { return const_iterator(this, nextFull_(0)); }
+        const_iterator end()   const { return const_iterator(this, capacity_); }
+
+        bool operator==(const FlatHashTable&) = delete;
+
+    protected:
+        /// Finds slot of key or constructs it from args. Slot is marked full only after construction succeeds.
+        template<class... Args>
+        std::pair<iterator, bool> emplaceSlot_(const key_type& key, Args&&... args)
+        {
+            size_t hash  = hashOf_(key);
+            size_t index = findIndex_(key, hash);
+            if(index != capacity_) return {iterator(this, index), false};
+
+            index = prepareInsert_(hash);
+            new(&slots_[index]) value_type(std::forward<Args>(args)...);
+            commitInsert_(index, hash);
+            return {iterator(this, index), true};
+        }
+
+        value_type* slotAt_(size_t index) { return &slots_[index]; }
+
+        size_t findIndex_(const key_type& key, size_t hash) const
+        {
+            if(capacity_ == 0) return 0;
+
+            int8_t h2     = h2Of_(hash);
+            size_t groups = capacity_ / GROUP_WIDTH - 1;
+            size_t group  = h1Of_(hash) & groups;
+            for(size_t step = 1; ; ++step)
+            {
+                CtrlGroup ctrl(ctrl_ + group * GROUP_WIDTH);
+                for(uint32_t match = ctrl.match(h2); match; match &= match - 1)
+                {
+                    size_t index = group * GROUP_WIDTH + std::countr_zero(match);
+                    if(eq_(Policy::key(slots_[index]), key)) [[likely]] return index;
+                }
+                if(ctrl.matchEmpty()) return capacity_;
+                group = (group + step) & groups;
+            }
+        }
+
+        size_t hashOf_(const key_type& key) const
+        {
+            // Standard hashes of integers are identity, so bits are mixed before they pick group and tag.
+            uint64_t hash = static_cast<uint64_t>(hash_(key)) * 0x9E3779B97F4A7C15ull;
+            return hash ^ (hash >> 32);
+        }
+
+    private:
+        int8_t*     rawCtrl_    = nullptr; ///< Control array as allocated, ctrl_ is its aligned part.
+        int8_t*     ctrl_       = nullptr;
+        value_type* slots_      = nullptr;
+        size_t      capacity_   = 0;
+        size_t      size_       = 0;
+        size_t      growthLeft_ = 0; ///< Inserts into empty slots left before rehash.
+
+        [[no_unique_address]] Hash hash_{};
+        [[no_unique_address]] Eq   eq_{};
+
+        Alloc<value_type> slotAlloc_{};
+        Alloc<int8_t>     ctrlAlloc_{};
+
+        static int8_t h2Of_(size_t hash) { return static_cast<int8_t>(hash & 0x7F); }
+        static size_t h1Of_(size_t hash) { return hash >> 7; }
+
+        /// At most 7/8 of slots are full or tombstones.
+        static size_t maxLoad_(size_t capacity) { return capacity - capacity / 8; }
+
+        static size_t capacityFor_(size_t n)
+        {
+            size_t capacity = std::bit_ceil(std::max(n + n / 7, GROUP_WIDTH));
+            return maxLoad_(capacity) < n ? capacity * 2 : capacity;
+        }
+
+        static Alloc<int8_t> rebind_(const Alloc<value_type>& alloc)
+        {
+            if constexpr (std::is_constructible_v<Alloc<int8_t>, const Alloc<value_type>&>) return Alloc<int8_t>(alloc);
+            else                                                                           return Alloc<int8_t>();
+        }
+
+        /// First full slot at index or after it, capacity_ if there is none.
+        size_t nextFull_(size_t index) const
+        {
+            for(size_t group = index & ~(GROUP_WIDTH - 1); group < capacity_; group += GROUP_WIDTH)
+            {
+                uint32_t full = CtrlGroup(ctrl_ + group).matchFull();
+                if(group < index) full &= CtrlGroup::ALL << (index - group);
+                if(full) return group + std::countr_zero(full);
+            }
+            return capacity_;
+        }
+
+        /// First empty or deleted slot on probe sequence of hash.
+        size_t findFree_(size_t hash) const
+        {
+            size_t groups = capacity_ / GROUP_WIDTH - 1;
+            size_t group  = h1Of_(hash) & groups;
+            for(size_t step = 1; ; ++step)
+            {
+                uint32_t free = CtrlGroup(ctrl_ + group * GROUP_WIDTH).matchFree();
+                if(free) return group * GROUP_WIDTH + std::countr_zero(free);
+                group = (group + step) & groups;
+            }
+        }
+
+        size_t prepareInsert_(size_t hash)
+        {
+            if(capacity_ == 0) rehash_(GROUP_WIDTH);
+
+            size_t index = findFree_(hash);
+            if(growthLeft_ == 0 && ctrl_[index] != CTRL_DELETED)
+            {
+                // Table full of tombstones is cleaned at same capacity, otherwise it doubles.
+                rehash_(size_ * 2 <= maxLoad_(capacity_) ? capacity_ : capacity_ * 2);
+                index = findFree_(hash);
+            }
+            return index;
+        }
+
+        void commitInsert_(size_t index, size_t hash)
+        {
+            if(ctrl_[index] == CTRL_EMPTY) --growthLeft_;
+            ctrl_[index] = h2Of_(hash);
+            ++size_;
+        }
+
+        void eraseAt_(size_t index)
+        {
+            slots_[index].~value_type();
+            --size_;
+            if(CtrlGroup(ctrl_ + (index & ~(GROUP_WIDTH - 1))).matchEmpty())
+            {
+                ctrl_[index] = CTRL_EMPTY;
+                ++growthLeft_;
+            }
+            else
+            {
+                ctrl_[index] = CTRL_DELETED;
+            }
+        }
+
+        void allocate_(int8_t*& rawCtrl, value_type*& slots, size_t capacity)
+        {
+            rawCtrl = nullptr;
+            slots   = nullptr;
+            if(capacity == 0) return;
+
+            // Groups are read with aligned loads, so control array is over-allocated and aligned by hand.
+            rawCtrl = ctrlAlloc_.allocate(capacity + GROUP_WIDTH);
+            if(!rawCtrl) throw Error::OutOfMemory;
+            try
+            {
+                slots = slotAlloc_.allocate(capacity);
+                if(!slots) throw Error::OutOfMemory;
+            }
+            catch(...)
+            {
+                ctrlAlloc_.deallocate(rawCtrl, capacity + GROUP_WIDTH);
+                rawCtrl = nullptr;
+                throw;
+            }
+        }
+
+        static int8_t* alignCtrl_(int8_t* ctrl)
+        {
+            auto address = reinterpret_cast<uintptr_t>(ctrl);
+            return ctrl + ((GROUP_WIDTH - address % GROUP_WIDTH) % GROUP_WIDTH);
+        }
+
+        void release_(int8_t* rawCtrl, value_type* slots, size_t capacity)
+        {
+            if(capacity == 0) return;
+            ctrlAlloc_.deallocate(rawCtrl, capacity + GROUP_WIDTH);
+            slotAlloc_.deallocate(slots, capacity);
+        }
+
+        /**
+         * @brief Moves elements into new arrays of given capacity. Trivially relocatable elements are copied
+         * by bytes. Others are moved when that cannot throw and copied otherwise, so failure leaves table as it was.
+         */
+        void rehash_(size_t capacity)
+        {
+            int8_t*     raw   = nullptr;
+            value_type* slots = nullptr;
+            allocate_(raw, slots, capacity);
+            int8_t* ctrl = capacity ? alignCtrl_(raw) : nullptr;
+            if(capacity) std::memset(ctrl, CTRL_EMPTY, capacity);
+
+            size_t groups = capacity / GROUP_WIDTH - 1;
+            auto findFreeIn = [ctrl, groups](size_t hash)
+            {
+                size_t group = h1Of_(hash) & groups;
+                for(size_t step = 1; ; ++step)
+                {
+                    uint32_t free = CtrlGroup(ctrl + group * GROUP_WIDTH).matchFree();
+                    if(free) return group * GROUP_WIDTH + std::countr_zero(free);
+                    group = (group + step) & groups;
+                }
+            };
+
+            if constexpr (is_trivially_relocatable_v<value_type>)
+            {
+                for(size_t i = nextFull_(0); i < capacity_; i = nextFull_(i + 1))
+                {
+                    size_t hash  = hashOf_(Policy::key(slots_[i]));
+                    size_t index = findFreeIn(hash);
+                    std::memcpy(static_cast<void*>(&slots[index]), &slots_[i], sizeof(value_type));
+                    ctrl[index] = h2Of_(hash);
+                }
+            }
+            else
+            {
+                size_t i = nextFull_(0);
+                try
+                {
+                    for(; i < capacity_; i = nextFull_(i + 1))
+                    {
+                        size_t hash  = hashOf_(Policy::key(slots_[i]));
+                        size_t index = findFreeIn(hash);
+                        new(&slots[index]) value_type(std::move_if_noexcept(slots_[i]));
+                        ctrl[index] = h2Of_(hash);
+                    }
+                }
+                catch(...)
+                {
+                    for(size_t j = 0; j < capacity; ++j)
+                    {
+                        if(ctrl[j] >= 0) slots[j].~value_type();
+                    }
+                    release_(raw, slots, capacity);
+                    throw;
+                }
+                destroySlots_();
+            }
+
+            release_(rawCtrl_, slots_, capacity_);
+            rawCtrl_    = raw;
+            ctrl_       = ctrl;
+            slots_      = slots;
+            capacity_   = capacity;
+            growthLeft_ = maxLoad_(capacity) - size_;
+        }
+
+        void destroySlots_()
+        {
+            if constexpr (!std::is_trivially_destructible_v<value_type>)
+            {
+                for(size_t i = nextFull_(0); i < capacity_; i = nextFull_(i + 1)) slots_[i].~value_type();
+            }
+        }
+
+        void copyFrom_(const FlatHashTable& oth)
+        {
+            reserve(oth.size_);
+            for(size_t i = oth.nextFull_(0); i < oth.capacity_; i = oth.nextFull_(i + 1))
+            {
+                emplaceSlot_(Policy::key(oth.slots_[i]), oth.slots_[i]);
+            }
+        }
+    };
+
+    /**
+     * @brief Forward iterator over full slots. Elements of sets are never mutable, keys of maps are const.
+     */
+    template<class Policy, class Hash, class Eq, template<class> class Alloc>
+    template<bool CONST>
+    class FlatHashTable<Policy, Hash, Eq, Alloc>::Iterator
+    {
+        using Table = std::conditional_t<CONST, const FlatHashTable, FlatHashTable>;
+
+        friend class FlatHashTable;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = FlatHashTable::value_type;
+        using difference_type   = std::ptrdiff_t;
+        using reference         = std::conditional_t<CONST || Policy::CONST_SLOTS, const value_type&, value_type&>;
+        using pointer           = std::remove_reference_t<reference>*;
+
+        Iterator() = default;
+        Iterator(Table* table, size_t index) : table_(table), index_(index) {}
+
+        /// Mutable iterator converts to const one.
+        template<bool OTHER_CONST>
+        requires (CONST && !OTHER_CONST)
+        Iterator(const Iterator<OTHER_CONST>& oth) : table_(oth.table_), index_(oth.index_) {}
+
+        reference operator*()  const { return table_->slots_[index_]; }
+        pointer   operator->() const { return &table_->slots_[index_]; }
+
+        Iterator& operator++() { index_ = table_->nextFull_(index_ + 1); return *this; }
+        Iterator  operator++(int) { Iterator old = *this; ++*this; return old; }
+
+        bool operator==(const Iterator& other) const { return index_ == other.index_; }
+
+    private:
+        template<bool>
+        friend class Iterator;
+
+        Table* table_ = nullptr;
+        size_t index_ = 0;
+    };
+
+}
+
+/**
+ * @brief Hash set stored in flat arrays, see detail::FlatHashTable. Insertion and rehash move elements,
+ * so pointers and iterators to elements are invalidated by them.
+ */
+template<class Key, class Hash = std::hash<Key>, class Eq = std::equal_to<Key>,
+         template<class> class Alloc = DefaultDynamicAllocator>
+class FlatHashSet : public detail::FlatHashTable<detail::SetPolicy<Key>, Hash, Eq, Alloc>
+{
+    using Base = detail::FlatHashTable<detail::SetPolicy<Key>, Hash, Eq, Alloc>;
+
+public:
+    using Base::Base;
+
+    template<class... Args>
+    std::pair<typename Base::iterator, bool> emplace(Args&&... args)
+    {
+        Key key(std::forward<Args>(args)...);
+        return this->emplaceSlot_(key, std::move(key));
+    }
+};
+
+/**
+ * @brief Hash map stored in flat arrays, see detail::FlatHashTable. Insertion and rehash move elements,
+ * so pointers and iterators to elements are invalidated by them.
+ */
+template<class Key, class Value, class Hash = std::hash<Key>, class Eq = std::equal_to<Key>,
+         template<class> class Alloc = DefaultDynamicAllocator>
+class FlatHashMap : public detail::FlatHashTable<detail::MapPolicy<Key, Value>, Hash, Eq, Alloc>
+{
+    using Base = detail::FlatHashTable<detail::MapPolicy<Key, Value>, Hash, Eq, Alloc>;
+
+public:
+    using mapped_type = Value;
+    using Error       = typename Base::Error;
+    using iterator    = typename Base::iterator;
+
+    using Base::Base;
+
+    /**
+     * @brief Constructs value from args unless key is present, args are not touched then.
+     */
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+    {
+        return this->emplaceSlot_(key, std::piecewise_construct, std::forward_as_tuple(key),
+                                  std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args)
+    {
+        return this->emplaceSlot_(key, std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+                                  std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    template<class V>
+    std::pair<iterator, bool> insert_or_assign(const Key& key, V&& value)
+    {
+        auto result = try_emplace(key, std::forward<V>(value));
+        if(!result.second) result.first->second = std::forward<V>(value);
+        return result;
+    }
+
+    Value& operator[](const Key& key) { return try_emplace(key).first->second; }
+    Value& operator[](Key&& key)      { return try_emplace(std::move(key)).first->second; }
+
+    Value& at(const Key& key)
+    {
+        auto it = this->find(key);
+        if(it == this->end()) throw Error::OutOfRange;
+        return it->second;
+    }
+
+    const Value& at(const Key& key) const
+    {
+        auto it = this->find(key);
+        if(it == this->end()) throw Error::OutOfRange;
+        return it->second;
+    }
+};
+
+}
+
+#endif /* MGKTL_MCONTAINERS_FLATHASHMAP_HPP */
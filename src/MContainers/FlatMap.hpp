@@ -0,0 +1,506 @@
+#ifndef MGKTL_MCONTAINERS_FLATMAP_HPP
+#define MGKTL_MCONTAINERS_FLATMAP_HPP
+
+#include <algorithm>
+#include <bit>
+#include <compare>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include <MData/Allocator.hpp>
+#include <MData/Vector.hpp>
+
+namespace mgk {
+
+namespace detail {
+
+    /**
+     * @brief Sorted unique keys with lower bound search. Frozen keys get second copy in Eytzinger order:
+     * node k has children 2k and 2k + 1, so search reads memory top-down and can prefetch levels ahead.
+     */
+    template<class Key, class Compare, template<class> class Alloc>
+    class SortedKeys
+    {
+    public:
+        enum class Error
+        {
+            OutOfRange,
+            BadObject,
+            DifferentContainerIterator,
+        };
+
+        using key_type    = Key;
+        using key_compare = Compare;
+
+        size_t size()  const { return keys_.size(); }
+        bool   empty() const { return keys_.size() == 0; }
+
+        bool validate() const noexcept(true)
+        {
+            const Key* keys = keys_.data();
+            for(size_t i = 1; i < keys_.size(); ++i)
+            {
+                if(!less_(keys[i - 1], keys[i])) return false;
+            }
+            return !frozen() || eytzinger_.size() == keys_.size() + 1;
+        }
+
+        void validateThrow() const noexcept(false)
+        {
+            if(!validate()) throw Error::BadObject;
+        }
+
+        std::span<const Key> keys() const { return {keys_.data(), keys_.size()}; }
+
+        bool   contains(const Key& key) const { return findIndex_(key) != keys_.size(); }
+        size_t count(const Key& key)    const { return contains(key) ? 1 : 0; }
+
+        /**
+         * @brief Builds Eytzinger copy of keys for faster lookups. Any change of keys drops it.
+         */
+        void freeze()
+        {
+            if(frozen()) return;
+
+            // Copies of empty vectors, they only carry allocators.
+            auto eytzinger = eytzinger_;
+            auto rank      = rank_;
+            eytzinger.resize(keys_.size() + 1);
+            rank.resize(keys_.size() + 1);
+
+            // Node 0 is unused, its rank means not found.
+            rank.data()[0] = keys_.size();
+            fill_(eytzinger.data(), rank.data(), 0, 1);
+
+            eytzinger_.swap(eytzinger);
+            rank_.swap(rank);
+        }
+
+        void thaw()
+        {
+            eytzinger_.clean();
+            rank_.clean();
+        }
+
+        bool frozen() const { return eytzinger_.size() != 0; }
+
+    protected:
+        Vector<Key, Alloc<Key>, UncheckedAccess> keys_;
+
+        [[no_unique_address]] Compare less_{};
+
+        SortedKeys() = default;
+
+        explicit SortedKeys(const Alloc<Key>& alloc) : keys_(alloc), eytzinger_(alloc), rank_(rebind_<size_t>(alloc)) {}
+
+        SortedKeys(const SortedKeys&)            = default;
+        SortedKeys(SortedKeys&&)                 = default;
+        SortedKeys& operator=(const SortedKeys&) = default;
+        SortedKeys& operator=(SortedKeys&&)      = default;
+
+        /// Defined out of line, so destruction of three vectors is not forced inline into every map and set.
+        ~SortedKeys();
+
+        /// Allocator of other type from same source when allocator converts, default one otherwise.
+        template<class T>
+        static Alloc<T> rebind_(const Alloc<Key>& alloc)
+        {
+            if constexpr (std::is_constructible_v<Alloc<T>, const Alloc<Key>&>) return Alloc<T>(alloc);
+            else                                                               return Alloc<T>();
+        }
+
+        /// Index of first key not less than key.
+        size_t lowerBound_(const Key& key) const
+        {
+            if(frozen()) return rank_.data()[eytzingerBound_(key)];
+
+            const Key* data = keys_.data();
+            size_t     n    = keys_.size();
+            if(n == 0) return 0;
+
+            // Halves range without branches on comparison, which are unpredictable on random keys.
+            const Key* base = data;
+            while(n > 1)
+            {
+                size_t half = n / 2;
+                base = less_(base[half - 1], key) ? base + half : base;
+                n -= half;
+            }
+            return static_cast<size_t>(base - data) + less_(*base, key);
+        }
+
+        /// Index of key, size() if it is absent.
+        size_t findIndex_(const Key& key) const
+        {
+            size_t i = lowerBound_(key);
+            return isKeyAt_(i, key) ? i : keys_.size();
+        }
+
+        bool isKeyAt_(size_t i, const Key& key) const
+        {
+            return i != keys_.size() && !less_(key, keys_.data()[i]);
+        }
+
+        /// Sorts permutation of input by key and keeps first of equal keys, returns indices of kept ones.
+        template<class KeyOf>
+        Vector<size_t, Alloc<size_t>, UncheckedAccess> sortedUnique_(size_t n, KeyOf keyOf) const
+        {
+            auto order = rank_;
+            order.resize(n);
+            size_t* first = order.data();
+            for(size_t i = 0; i < n; ++i) first[i] = i;
+
+            std::stable_sort(first, first + n, [&](size_t a, size_t b) { return less_(keyOf(a), keyOf(b)); });
+            size_t* last = std::unique(first, first + n, [&](size_t a, size_t b) { return !less_(keyOf(a), keyOf(b)); });
+            order.resize(static_cast<size_t>(last - first));
+            return order;
+        }
+
+    private:
+        /// Keys per cache line, search prefetches that many levels below.
+        static constexpr size_t LINE_KEYS = std::bit_floor(std::max<size_t>(64 / sizeof(Key), 1));
+
+        Vector<Key, Alloc<Key>, UncheckedAccess>       eytzinger_;
+        Vector<size_t, Alloc<size_t>, UncheckedAccess> rank_; ///< Index in keys_ of every Eytzinger node.
+
+        /// Fills subtree of node k with sorted keys from i onwards, returns index of next key.
+        size_t fill_(Key* eytzinger, size_t* rank, size_t i, size_t k) const
+        {
+            if(k > keys_.size()) return i;
+
+            i = fill_(eytzinger, rank, i, 2 * k);
+            eytzinger[k] = keys_.data()[i];
+            rank[k]      = i;
+            return fill_(eytzinger, rank, i + 1, 2 * k + 1);
+        }
+
+        /// Eytzinger node of lower bound, 0 if all keys are less.
+        size_t eytzingerBound_(const Key& key) const
+        {
+            const Key* tree = eytzinger_.data();
+            size_t     n    = keys_.size();
+            size_t     k    = 1;
+            while(k <= n)
+            {
+                // Prefetch address is never dereferenced, it may point past the end.
+                __builtin_prefetch(tree + k * LINE_KEYS);
+                k = 2 * k + less_(tree[k], key);
+            }
+            // Last left turn is the answer: drop right turns made after it, then the turn itself.
+            return k >> (std::countr_one(k) + 1);
+        }
+    };
+
+    template<class Key, class Compare, template<class> class Alloc>
+    SortedKeys<Key, Compare, Alloc>::~SortedKeys() = default;
+
+}
+
+/**
+ * @brief Sorted set over Vector. Lookups are binary searches over contiguous keys, insert and erase shift the tail.
+ * Build from unsorted range at once when possible: that sorts once instead of shifting per key.
+ */
+template<class Key, class Compare = std::less<Key>, template<class> class Alloc = DefaultDynamicAllocator>
+class FlatSet : public detail::SortedKeys<Key, Compare, Alloc>
+{
+    using Base = detail::SortedKeys<Key, Compare, Alloc>;
+
+public:
+    using value_type     = Key;
+    using Error          = typename Base::Error;
+    using const_iterator = const Key*;
+    using iterator       = const_iterator;
+
+    FlatSet() = default;
+
+    explicit FlatSet(const Alloc<Key>& alloc) : Base(alloc) {}
+
+    /**
+     * @brief Takes keys of [first, last) in any order. Of equal keys first one is kept.
+     */
+    template<std::forward_iterator Iter>
+    FlatSet(Iter first, Iter last, const Alloc<Key>& alloc = Alloc<Key>()) : FlatSet(alloc)
+    {
+        Vector<Key, Alloc<Key>, UncheckedAccess> input(alloc);
+        input.insert(input.end(), first, last);
+
+        const Key* keys  = input.data();
+        auto       order = this->sortedUnique_(input.size(), [keys](size_t i) -> const Key& { return keys[i]; });
+        this->keys_.reserve(order.size());
+        for(size_t i : order) this->keys_.push_back(std::move(input.data()[i]));
+    }
+
+    FlatSet(std::initializer_list<Key> keys, const Alloc<Key>& alloc = Alloc<Key>()) : FlatSet(keys.begin(), keys.end(), alloc) {}
+
+    const_iterator find(const Key& key) const { return begin() + this->findIndex_(key); }
+
+    const_iterator lower_bound(const Key& key) const { return begin() + this->lowerBound_(key); }
+
+    std::pair<iterator, bool> insert(const Key& key)
+    {
+        size_t i = this->lowerBound_(key);
+        if(this->isKeyAt_(i, key)) return {begin() + i, false};
+
+        this->thaw();
+        this->keys_.insert(this->keys_.begin() + i, &key, &key + 1);
+        return {begin() + i, true};
+    }
+
+    size_t erase(const Key& key)
+    {
+        size_t i = this->findIndex_(key);
+        if(i == this->size()) return 0;
+
+        this->thaw();
+        this->keys_.erase(this->keys_.begin() + i);
+        return 1;
+    }
+
+    void clean()
+    {
+        this->thaw();
+        this->keys_.clean();
+    }
+
+    const_iterator begin() const { return this->keys_.data(); }
+    const_iterator end()   const { return this->keys_.data() + this->keys_.size(); }
+
+    bool operator==(const FlatSet&) = delete;
+};
+
+/**
+ * @brief Sorted map over two Vectors, one of keys and one of values, so searches touch keys only.
+ * Elements are accessed through pairs of references. Build from unsorted range at once when possible.
+ */
+template<class Key, class Value, class Compare = std::less<Key>, template<class> class Alloc = DefaultDynamicAllocator>
+class FlatMap : public detail::SortedKeys<Key, Compare, Alloc>
+{
+    using Base = detail::SortedKeys<Key, Compare, Alloc>;
+
+    template<bool CONST>
+    class Iterator;
+
+public:
+    using mapped_type     = Value;
+    using value_type      = std::pair<Key, Value>;
+    using reference       = std::pair<const Key&, Value&>;
+    using const_reference = std::pair<const Key&, const Value&>;
+    using Error           = typename Base::Error;
+
+    using iterator       = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    FlatMap() = default;
+
+    explicit FlatMap(const Alloc<Key>& alloc) : Base(alloc), values_(Base::template rebind_<Value>(alloc)) {}
+
+    /**
+     * @brief Takes key-value pairs of [first, last) in any order. Of equal keys first one is kept.
+     */
+    template<std::forward_iterator Iter>
+    FlatMap(Iter first, Iter last, const Alloc<Key>& alloc = Alloc<Key>()) : FlatMap(alloc)
+    {
+        Vector<value_type, Alloc<value_type>, UncheckedAccess> input(Base::template rebind_<value_type>(alloc));
+        input.insert(input.end(), first, last);
+
+        value_type* pairs = input.data();
+        auto        order = this->sortedUnique_(input.size(), [pairs](size_t i) -> const Key& { return pairs[i].first; });
+        this->keys_.reserve(order.size());
+        values_.reserve(order.size());
+        for(size_t i : order)
+        {
+            this->keys_.push_back(std::move(pairs[i].first));
+            values_.push_back(std::move(pairs[i].second));
+        }
+    }
+
+    FlatMap(std::initializer_list<value_type> pairs, const Alloc<Key>& alloc = Alloc<Key>())
+        : FlatMap(pairs.begin(), pairs.end(), alloc) {}
+
+    std::span<Value>       values()       { return {values_.data(), values_.size()}; }
+    std::span<const Value> values() const { return {values_.data(), values_.size()}; }
+
+    iterator       find(const Key& key)       { return iterator(this, this->findIndex_(key)); }
+    const_iterator find(const Key& key) const { return const_iterator(this, this->findIndex_(key)); }
+
+    iterator       lower_bound(const Key& key)       { return iterator(this, this->lowerBound_(key)); }
+    const_iterator lower_bound(const Key& key) const { return const_iterator(this, this->lowerBound_(key)); }
+
+    /**
+     * @brief Constructs value from args unless key is present, args are not touched then.
+     */
+    template<class K, class... Args>
+    requires std::constructible_from<Key, K&&>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args)
+    {
+        size_t i = this->lowerBound_(key);
+        if(this->isKeyAt_(i, key)) return {iterator(this, i), false};
+
+        Value value(std::forward<Args>(args)...);
+        Key   newKey(std::forward<K>(key));
+        this->thaw();
+        this->keys_.insert(this->keys_.begin() + i, std::make_move_iterator(&newKey), std::make_move_iterator(&newKey + 1));
+        try
+        {
+            values_.insert(values_.begin() + i, std::make_move_iterator(&value), std::make_move_iterator(&value + 1));
+        }
+        catch(...)
+        {
+            this->keys_.erase(this->keys_.begin() + i);
+            throw;
+        }
+        return {iterator(this, i), true};
+    }
+
+    std::pair<iterator, bool> insert(const value_type& pair) { return try_emplace(pair.first, pair.second); }
+
+    template<class V>
+    std::pair<iterator, bool> insert_or_assign(const Key& key, V&& value)
+    {
+        size_t i = this->lowerBound_(key);
+        if(!this->isKeyAt_(i, key)) return try_emplace(key, std::forward<V>(value));
+
+        values_.data()[i] = std::forward<V>(value);
+        return {iterator(this, i), false};
+    }
+
+    Value& operator[](const Key& key) { return try_emplace(key).first->second; }
+
+    Value& at(const Key& key)
+    {
+        size_t i = this->findIndex_(key);
+        if(i == this->size()) throw Error::OutOfRange;
+        return values_.data()[i];
+    }
+
+    const Value& at(const Key& key) const
+    {
+        size_t i = this->findIndex_(key);
+        if(i == this->size()) throw Error::OutOfRange;
+        return values_.data()[i];
+    }
+
+    size_t erase(const Key& key)
+    {
+        size_t i = this->findIndex_(key);
+        if(i == this->size()) return 0;
+
+        eraseAt_(i);
+        return 1;
+    }
+
+    /// Returns iterator to next element.
+    iterator erase(const_iterator pos)
+    {
+        if(pos.map_ != this) throw Error::DifferentContainerIterator;
+        if(pos.position_ >= this->size()) throw Error::OutOfRange;
+
+        eraseAt_(pos.position_);
+        return iterator(this, pos.position_);
+    }
+
+    void reserve(size_t n)
+    {
+        this->keys_.reserve(n);
+        values_.reserve(n);
+    }
+
+    void clean()
+    {
+        this->thaw();
+        this->keys_.clean();
+        values_.clean();
+    }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end()   { return iterator(this, this->size()); }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end()   const { return const_iterator(this, this->size()); }
+
+    bool operator==(const FlatMap&) = delete;
+
+private:
+    Vector<Value, Alloc<Value>, UncheckedAccess> values_;
+
+    void eraseAt_(size_t i)
+    {
+        this->thaw();
+        this->keys_.erase(this->keys_.begin() + i);
+        values_.erase(values_.begin() + i);
+    }
+};
+
+/**
+ * @brief Random access iterator over map. Dereferencing gives pair of references to key and value.
+ */
+template<class Key, class Value, class Compare, template<class> class Alloc>
+template<bool CONST>
+class FlatMap<Key, Value, Compare, Alloc>::Iterator
+{
+    using Map = std::conditional_t<CONST, const FlatMap, FlatMap>;
+
+    friend class FlatMap;
+
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type        = FlatMap::value_type;
+    using difference_type   = std::ptrdiff_t;
+    using reference         = std::conditional_t<CONST, FlatMap::const_reference, FlatMap::reference>;
+
+    /// Keeps pair of references alive for operator->.
+    struct Arrow
+    {
+        reference ref;
+        const reference* operator->() const { return &ref; }
+    };
+
+    Iterator() = default;
+    Iterator(Map* map, size_t position) : map_(map), position_(position) {}
+
+    /// Mutable iterator converts to const one.
+    template<bool OTHER_CONST>
+    requires (CONST && !OTHER_CONST)
+    Iterator(const Iterator<OTHER_CONST>& oth) : map_(oth.map_), position_(oth.position_) {}
+
+    reference operator*() const { return reference(map_->keys_.data()[position_], map_->values_.data()[position_]); }
+    Arrow     operator->() const { return Arrow{**this}; }
+    reference operator[](difference_type diff) const { return *(*this + diff); }
+
+    Iterator& operator++() { ++position_; return *this; }
+    Iterator& operator--() { --position_; return *this; }
+    Iterator operator++(int) { Iterator old = *this; ++position_; return old; }
+    Iterator operator--(int) { Iterator old = *this; --position_; return old; }
+
+    Iterator& operator+=(difference_type diff) { position_ += diff; return *this; }
+    Iterator& operator-=(difference_type diff) { position_ -= diff; return *this; }
+
+    Iterator operator+(difference_type diff) const { return Iterator(map_, position_ + diff); }
+    Iterator operator-(difference_type diff) const { return Iterator(map_, position_ - diff); }
+    friend Iterator operator+(difference_type diff, const Iterator& it) { return it + diff; }
+
+    difference_type operator-(const Iterator& other) const
+    {
+        if(map_ != other.map_) throw Error::DifferentContainerIterator;
+        return static_cast<difference_type>(position_) - static_cast<difference_type>(other.position_);
+    }
+
+    bool operator==(const Iterator& other) const { return position_ == other.position_; }
+    auto operator<=>(const Iterator& other) const { return position_ <=> other.position_; }
+
+private:
+    template<bool>
+    friend class Iterator;
+
+    Map*   map_      = nullptr;
+    size_t position_ = 0;
+};
+
+}
+
+#endif /* MGKTL_MCONTAINERS_FLATMAP_HPP */
@@ -5,27 +5,32 @@
 #include <cstddef>
 #include <cassert>
 #include <cstdlib>
+#include <iterator>
+#include <new>
+#include <span>
 #include <type_traits>
 #include <utility>
 #include <MUtils/utils.hpp>
+#include <MData/Allocator.hpp>
+#include <MData/AllocatorConcepts.hpp>
+#include <MData/Vector.hpp>
 namespace mgk {
 
     template<typename T>
     using Ptr = T*;
 
-    template<class T, template<typename> class Pointer = Ptr, class Updater = void(*)()>
+    /**
+     * @brief Implicit treap.
+     *
+     * @tparam Pointer - pointer to node. Smart pointers own nodes themselves.
+     * @tparam Updater - callback called on node after its subtree changes.
+     * @tparam Alloc   - allocator of nodes. Used only when Pointer is raw pointer.
+     */
+    template<class T, template<typename> class Pointer = Ptr, class Updater = void(*)(),
+             template<typename> class Alloc = DefaultDynamicAllocator>
     class Treap
     {
     public:
-    
-    Treap() = default;
-    Treap(Updater upd) : updatef_(upd) {}
-
-    ~Treap() {
-        if constexpr (std::is_same<Pointer<Node>, Node*>::value) {
-            delete root_;
-        }
-    }
         struct Node
         {
             T key; 
@@ -34,14 +39,37 @@ namespace mgk {
 
             std::size_t priority_ = std::rand();
             std::size_t size_ = 1;
-
-            ~Node() {
-                if constexpr (std::is_same<Pointer<Node>, Node*>::value){
-                    delete left;
-                    delete right;
-                }
-            }
         };
+
+        using NodeAllocator = Alloc<Node>;
+
+    Treap() : updatef_(), alloc_() {}
+    Treap(Updater upd) : updatef_(upd), alloc_() {}
+    explicit Treap(const NodeAllocator& alloc) : updatef_(), alloc_(alloc) {}
+    Treap(Updater upd, const NodeAllocator& alloc) : updatef_(upd), alloc_(alloc) {}
+
+    // Copy would share nodes, both copies would free them.
+    Treap(const Treap&)            = delete;
+    Treap& operator=(const Treap&) = delete;
+
+    Treap(Treap&& oth) : root_(mgk::move(oth.root_)), updatef_(mgk::move(oth.updatef_)), alloc_(mgk::move(oth.alloc_)) {
+        oth.root_ = nullptr;
+    }
+
+    Treap& operator=(Treap&& oth) {
+        swap(oth);
+        return *this;
+    }
+
+    void swap(Treap& oth) {
+        std::swap(root_,    oth.root_);
+        std::swap(updatef_, oth.updatef_);
+        std::swap(alloc_,   oth.alloc_);
+    }
+
+    ~Treap() {
+        destroy(root_);
+    }
     
     [[nodiscard]]
     std::pair<Pointer<Node>, Pointer<Node>> splitKey(Pointer<Node> node, const T& key)
@@ -115,13 +143,80 @@ namespace mgk {
 
     [[nodiscard]]
     Pointer<Node> createNode(T key) {
-        return Pointer<Node>(new Node(mgk::move(key)));
+        if constexpr (IS_RAW_PTR) {
+            Node* node = alloc_.allocate();
+            try {
+                return new(node) Node(mgk::move(key));
+            } catch(...) {
+                alloc_.deallocate(node);
+                throw;
+            }
+        } else {
+            return Pointer<Node>(new Node(mgk::move(key)));
+        }
     }
 
-    void deleteNode(Pointer<Node> node) {
-        if constexpr (std::is_same<Pointer<Node>, Node*>::value) {
-            delete node;
+    /**
+     * @brief Replaces content of treap with keys from [first, last) in their order, in linear time. Returns new root.
+     *
+     * Nodes are taken from allocator in batches when it is BatchAllocator.
+     */
+    template<std::input_iterator Iter>
+    Pointer<Node> build(Iter first, Iter last) {
+        // Right spine of built part, spine[0] is its root.
+        Vector<Pointer<Node>, DefaultDynamicAllocator<Pointer<Node>>, UncheckedAccess> spine;
+        Node*  batch[BATCH_SZ] = {};
+        size_t next = 0, count = 0;
+
+        try {
+            for(; first != last; ++first) {
+                Pointer<Node> node = nullptr;
+                if constexpr (IS_BATCH) {
+                    if(next == count) {
+                        alloc_.allocate_n(BATCH_SZ, batch);
+                        next  = 0;
+                        count = BATCH_SZ;
+                    }
+                    node = new(batch[next]) Node(*first);
+                    ++next;
+                } else {
+                    node = createNode(*first);
+                }
+
+                Pointer<Node> left = nullptr;
+                while(!spine.empty() && spine[spine.size() - 1]->priority_ < node->priority_) {
+                    left = spine[spine.size() - 1];
+                    spine.pop_back();
+                    update(left);
+                }
+                node->left = left;
+                if(!spine.empty()) spine[spine.size() - 1]->right = node;
+                spine.push_back(node);
+            }
+        } catch(...) {
+            if constexpr (IS_BATCH) {
+                alloc_.deallocate_batch(std::span<Node* const>(batch + next, count - next));
+            }
+            if(!spine.empty()) destroy(spine[0]);
+            throw;
         }
+
+        if constexpr (IS_BATCH) {
+            alloc_.deallocate_batch(std::span<Node* const>(batch + next, count - next));
+        }
+        for(size_t i = spine.size(); i != 0; --i) {
+            update(spine[i - 1]);
+        }
+        destroy(root_);
+        root_ = spine.empty() ? nullptr : spine[0];
+        return root_;
+    }
+
+    /**
+     * @brief Deletes node with its whole subtree.
+     */
+    void deleteNode(Pointer<Node> node) {
+        destroy(node);
     }
 
     T& operator[](size_t i) const {
@@ -147,6 +242,44 @@ namespace mgk {
     size_t getNodeSize(Pointer<Node> node) const {return node ? node->size_ : 0;}
 
     private:
+        static constexpr bool IS_RAW_PTR = std::is_same<Pointer<Node>, Node*>::value;
+        static constexpr bool IS_BATCH   = IS_RAW_PTR && BatchAllocator<Node, Alloc>;
+        static constexpr size_t BATCH_SZ = 64;
+
+        void destroy(Pointer<Node> node) {
+            if constexpr (IS_RAW_PTR) {
+                // Monotonic allocator frees nodes in bulk. Nothing to do if keys need no destruction.
+                if constexpr (AllocatorTraits<NodeAllocator>::is_monotonic && std::is_trivially_destructible<T>::value) {
+                    return;
+                }
+                if constexpr (IS_BATCH) {
+                    Node*  batch[BATCH_SZ];
+                    size_t count = 0;
+                    destroyInto(node, batch, count);
+                    alloc_.deallocate_batch(std::span<Node* const>(batch, count));
+                    return;
+                }
+                if(!node) return;
+                destroy(node->left);
+                destroy(node->right);
+                node->~Node();
+                alloc_.deallocate(node);
+            }
+        }
+
+        /// Destroys subtree, freed nodes are collected into batch and given back BATCH_SZ at a time.
+        void destroyInto(Node* node, Node** batch, size_t& count) {
+            if(!node) return;
+            destroyInto(node->left,  batch, count);
+            destroyInto(node->right, batch, count);
+            node->~Node();
+            batch[count++] = node;
+            if(count == BATCH_SZ) {
+                alloc_.deallocate_batch(std::span<Node* const>(batch, count));
+                count = 0;
+            }
+        }
+
         void update(Pointer<Node> node) {
             if(!node) return;
             node->size_ =  1 + (node->right ? node->right->size_ : 0) +
@@ -160,6 +293,7 @@ namespace mgk {
     private:
         Pointer<Node> root_ = nullptr;
         Updater updatef_;
+        NodeAllocator alloc_;
     };
     
 }
@@ -1,12 +1,345 @@
+#include "MData/ArenaAllocator.hpp"
 #include "MData/Pointers.hpp"
 #include "MIo/stream.hpp"
+#include "MUtils/function.hpp"
+#include "ConcurrentQueue.hpp"
+#include "FlatHashMap.hpp"
+#include "FlatMap.hpp"
 #include "Treap.hpp"
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdlib>
+#include <map>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 using Treap = mgk::Treap<size_t, mgk::CringePtr>;
 
+template<class RawTreap>
+static void fillTreap(RawTreap& treap, size_t n) {
+    for(size_t i = 0; i < n; ++i) {
+        treap.setRoot(treap.merge(treap.getRoot(), treap.createNode(i)));
+    }
+    assert(treap.getNodeSize(treap.getRoot()) == n);
+    for(size_t i = 0; i < n; ++i) {
+        assert(treap[i] == i);
+    }
+}
+
+static void testTreapAllocators() {
+    {
+        mgk::Treap<size_t> treap;
+        fillTreap(treap, 1000);
+    }
+
+    mgk::Arena arena;
+    for(size_t round = 0; round < 4; ++round) {
+        using ArenaTreap = mgk::Treap<size_t, mgk::Ptr, void(*)(), mgk::ArenaAllocator>;
+        ArenaTreap treap{mgk::ArenaAllocator<size_t>(arena)};
+        fillTreap(treap, 10000);
+        arena.reset();
+    }
+}
+
+template<class AnyTreap>
+static void checkBuild(AnyTreap& treap, size_t n) {
+    std::vector<size_t> keys(n);
+    for(size_t i = 0; i < n; ++i) keys[i] = i;
+
+    treap.build(keys.begin(), keys.end());
+    assert(treap.getNodeSize(treap.getRoot()) == n);
+    for(size_t i = 0; i < n; ++i) {
+        assert(treap[i] == i);
+    }
+
+    treap.setRoot(treap.merge(treap.getRoot(), treap.createNode(n)));
+    assert(treap[n] == n);
+}
+
+static void testTreapBuild() {
+    using BucketTreap = mgk::Treap<size_t, mgk::Ptr, void(*)(), mgk::BucketAllocator>;
+    static_assert(mgk::BatchAllocator<BucketTreap::Node, mgk::BucketAllocator>);
+
+    for(size_t n : {0, 1, 63, 64, 65, 10000}) {
+        BucketTreap bucket;
+        checkBuild(bucket, n);
+
+        // Nodes and pages which hold them go along.
+        BucketTreap moved(std::move(bucket));
+        assert(moved.getNodeSize(moved.getRoot()) == n + 1 && !bucket.getRoot());
+        bucket = std::move(moved);
+        assert(bucket[n] == n && !moved.getRoot());
+        mgk::Treap<size_t> plain;
+        checkBuild(plain, n);
+    }
+    Treap cringe;
+    checkBuild(cringe, 1000);
+}
+
+static void testFlatHashMap() {
+    mgk::FlatHashMap<size_t, std::string> map;
+    std::unordered_map<size_t, std::string> reference;
+
+    // Small key range makes inserts hit erased keys, so tombstones are reused and cleaned by rehash.
+    for(size_t i = 0; i < 200000; ++i) {
+        size_t key = static_cast<size_t>(rand()) % 5000;
+        switch(rand() % 4) {
+        case 0:
+        case 1: {
+            bool inserted = map.try_emplace(key, std::to_string(i)).second;
+            assert(inserted == reference.emplace(key, std::to_string(i)).second);
+            break;
+        }
+        case 2:
+            assert(map.erase(key) == reference.erase(key));
+            break;
+        default:
+            map[key] += 'x';
+            reference[key] += 'x';
+        }
+    }
+    assert(map.validate());
+    assert(map.size() == reference.size());
+    for(const auto& [key, value] : reference) {
+        assert(map.at(key) == value);
+    }
+
+    size_t visited = 0;
+    for(const auto& [key, value] : map) {
+        assert(reference.at(key) == value);
+        ++visited;
+    }
+    assert(visited == map.size());
+
+    auto copy = map;
+    for(auto it = map.begin(); it != map.end();) {
+        it = it->first % 2 ? map.erase(it) : ++it;
+    }
+    for(const auto& [key, value] : reference) {
+        assert(map.contains(key) == (key % 2 == 0));
+        assert(copy.at(key) == value);
+    }
+
+    map.insert_or_assign(7, "seven");
+    assert(map.at(7) == "seven");
+    bool thrown = false;
+    try {
+        (void)map.at(100000);
+    } catch(decltype(map)::Error error) {
+        thrown = error == decltype(map)::Error::OutOfRange;
+    }
+    assert(thrown);
+
+    map.clean();
+    assert(map.empty() && map.begin() == map.end() && map.capacity() != 0);
+    map.shrink_to_fit();
+    assert(map.capacity() == 0 && !map.contains(7));
+}
+
+struct BadHash {
+    size_t operator()(size_t key) const { return key % 3; }
+};
+
+static void testFlatHashSet() {
+    // Colliding hashes make probes cross many groups.
+    mgk::FlatHashSet<size_t, BadHash> colliding;
+    for(size_t i = 0; i < 1000; ++i) {
+        assert(colliding.insert(i).second);
+        assert(!colliding.emplace(i).second);
+    }
+    for(size_t i = 0; i < 1000; i += 2) {
+        colliding.erase(i);
+    }
+    for(size_t i = 0; i < 1000; ++i) {
+        assert(colliding.contains(i) == (i % 2 == 1));
+    }
+
+    mgk::Arena arena;
+    {
+        using ArenaSet = mgk::FlatHashSet<std::string, std::hash<std::string>, std::equal_to<std::string>, mgk::ArenaAllocator>;
+        ArenaSet set{mgk::ArenaAllocator<std::string>(arena)};
+        std::unordered_set<std::string> reference;
+        set.reserve(1000);
+        size_t capacity = set.capacity();
+        for(size_t i = 0; i < 1000; ++i) {
+            set.insert(std::to_string(i * 7919 % 1000));
+            reference.insert(std::to_string(i * 7919 % 1000));
+        }
+        assert(set.capacity() == capacity);
+        assert(set.size() == reference.size());
+        for(const auto& key : reference) {
+            assert(set.contains(key));
+        }
+    }
+}
+
+static void testFlatMap() {
+    std::vector<std::pair<size_t, std::string>> input;
+    std::map<size_t, std::string> reference;
+    for(size_t i = 0; i < 3000; ++i) {
+        size_t key = static_cast<size_t>(rand()) % 4000 * 2;
+        input.emplace_back(key, std::to_string(i));
+        reference.emplace(key, std::to_string(i));
+    }
+
+    mgk::FlatMap<size_t, std::string> map(input.begin(), input.end());
+    assert(map.validate());
+    assert(map.size() == reference.size());
+
+    // Odd keys are absent, so searches end between keys and past both ends.
+    for(bool frozen : {false, true}) {
+        if(frozen) map.freeze();
+        assert(map.frozen() == frozen && map.validate());
+        for(size_t key = 0; key < 8002; ++key) {
+            auto expected = reference.lower_bound(key);
+            auto it = map.lower_bound(key);
+            if(expected == reference.end()) {
+                assert(it == map.end());
+            } else {
+                assert(it->first == expected->first && it->second == expected->second);
+            }
+            assert(map.contains(key) == reference.count(key));
+        }
+    }
+
+    map[1] = "one";
+    assert(!map.frozen() && map.at(1) == "one" && map.validate());
+    assert(!map.try_emplace(1, "uno").second);
+    map.insert_or_assign(1, "uno");
+    assert(map.at(1) == "uno");
+    assert(map.erase(1) == 1 && map.erase(1) == 0);
+
+    for(auto it = map.begin(); it != map.end();) {
+        it = (*it).first % 4 ? map.erase(it) : it + 1;
+    }
+    size_t kept = 0;
+    for(const auto& [key, value] : reference) {
+        if(key % 4 == 0) {
+            assert(map.at(key) == value);
+            ++kept;
+        }
+    }
+    assert(map.size() == kept && map.validate());
+
+    bool thrown = false;
+    try {
+        (void)map.at(3);
+    } catch(decltype(map)::Error error) {
+        thrown = error == decltype(map)::Error::OutOfRange;
+    }
+    assert(thrown);
+
+    mgk::Arena arena;
+    using ArenaSet = mgk::FlatSet<int, std::greater<int>, mgk::ArenaAllocator>;
+    ArenaSet set({5, 1, 9, 5, 3}, mgk::ArenaAllocator<int>(arena));
+    assert(set.size() == 4 && *set.begin() == 9 && set.validate());
+    set.freeze();
+    assert(*set.lower_bound(4) == 3 && set.lower_bound(0) == set.end() && set.find(4) == set.end());
+    assert(set.insert(4).second && !set.insert(4).second && !set.frozen());
+    assert(*set.lower_bound(4) == 4 && set.erase(9) == 1 && *set.begin() == 5);
+}
+
+static void testSpscQueue() {
+    constexpr size_t N = 200000;
+    mgk::SpscQueue<size_t> queue(1000);
+    assert(queue.capacity() == 1024);
+
+    std::thread producer([&queue] {
+        size_t batch[7];
+        for(size_t next = 0; next < N;) {
+            if(next % 3) {
+                queue.push(next++);
+                continue;
+            }
+            size_t n = std::min<size_t>(7, N - next);
+            for(size_t i = 0; i < n; ++i) batch[i] = next + i;
+            next += queue.try_push_n(batch, n);
+        }
+    });
+
+    size_t expected = 0;
+    size_t batch[5];
+    while(expected < N) {
+        size_t value = 0;
+        if(expected % 2 && queue.try_pop(value)) {
+            assert(value == expected++);
+        }
+        size_t n = queue.try_pop_n(batch, 5);
+        for(size_t i = 0; i < n; ++i) assert(batch[i] == expected++);
+    }
+    producer.join();
+    assert(queue.empty());
+
+    // Elements left in queue are destroyed with it.
+    mgk::SpscQueue<std::string> strings(4);
+    for(size_t i = 0; i < 4; ++i) assert(strings.try_push(std::string(100, 'a')));
+    assert(!strings.try_push("full"));
+}
+
+static void testMpmcQueue() {
+    constexpr size_t PRODUCERS = 3, CONSUMERS = 3, N = 50000;
+    mgk::MpmcQueue<size_t> queue(64);
+    std::atomic<size_t> sum = 0, popped = 0;
+
+    std::vector<std::thread> threads;
+    for(size_t p = 0; p < PRODUCERS; ++p) {
+        threads.emplace_back([&queue, p] {
+            size_t batch[4];
+            for(size_t i = 0; i < N;) {
+                if(i % 2) {
+                    queue.push(p * N + i++ + 1);
+                    continue;
+                }
+                size_t n = std::min<size_t>(4, N - i);
+                for(size_t j = 0; j < n; ++j) batch[j] = p * N + i + j + 1;
+                i += queue.try_push_n(batch, n);
+            }
+        });
+    }
+    for(size_t c = 0; c < CONSUMERS; ++c) {
+        threads.emplace_back([&queue, &sum, &popped] {
+            size_t batch[3];
+            while(popped.load() < PRODUCERS * N) {
+                size_t value = 0;
+                if(queue.try_pop(value)) {
+                    sum += value;
+                    ++popped;
+                }
+                size_t n = queue.try_pop_n(batch, 3);
+                for(size_t i = 0; i < n; ++i) sum += batch[i];
+                popped += n;
+            }
+        });
+    }
+    for(auto& thread : threads) thread.join();
+    assert(popped == PRODUCERS * N);
+    assert(sum == PRODUCERS * N * (PRODUCERS * N + 1) / 2);
+    assert(queue.empty());
+
+    // Tasks are moved through queue and run by other thread.
+    mgk::MpmcQueue<mgk::UniqueFunction<void()>> tasks(8);
+    std::atomic<size_t> done = 0;
+    std::thread worker([&tasks, &done] {
+        for(size_t i = 0; i < 100; ++i) {
+            mgk::UniqueFunction<void()> task;
+            tasks.pop(task);
+            task();
+        }
+        assert(done == 100);
+    });
+    for(size_t i = 0; i < 100; ++i) {
+        tasks.push([&done] { ++done; });
+    }
+    worker.join();
+
+    mgk::MpmcQueue<std::string> strings(2);
+    assert(strings.try_emplace(50, 'b') && strings.try_push("x") && !strings.try_push("y"));
+}
+
 static void shift(Treap& treap, size_t k) {
     auto root = treap.getRoot();
     auto [l,r] = treap.splitSize(root, k);
@@ -15,6 +348,14 @@ static void shift(Treap& treap, size_t k) {
 }
 
 int main() {
+    testFlatHashMap();
+    testFlatHashSet();
+    testFlatMap();
+    testSpscQueue();
+    testMpmcQueue();
+    testTreapBuild();
+    testTreapAllocators();
+
     Treap treap;
 
     for(size_t i = 0; i < 1000; ++i) {
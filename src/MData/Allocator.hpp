@@ -1,6 +1,7 @@
 #ifndef ALLOCATOR_HPP
 #define ALLOCATOR_HPP
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -8,9 +9,13 @@
 #include <exception>
 #include <stdexcept>
 #include <new>
+#include <initializer_list>
+#include <span>
 #include <type_traits>
+#include <utility>
 
 #include <MUtils/defines.hpp>
+#include "PageProvider.hpp"
 
 namespace mgk {
 
@@ -20,14 +25,14 @@ class DefaultDynamicAllocator
 public:
     using value_type = T;
 
-    [[nodiscard]] T* allocate(size_t size)
+    [[nodiscard]] T* allocate(size_t size = 1)
     {
-        return reinterpret_cast<T*>(new char[size * sizeof(T)]);
+        return static_cast<T*>(::operator new(size * sizeof(T)));
     }
 
-    void deallocate(T* ptr, size_t)
+    void deallocate(T* ptr, size_t = 1)
     {
-        delete [] ptr;
+        ::operator delete(ptr);
     }
 };
 
@@ -43,57 +48,239 @@ public:
 
     void deallocate(T* ptr, size_t = 1)
     {
-        delete [] ptr;
+        free(ptr);
+    }
+
+    /**
+     * @brief Resizes block keeping its bytes, see realloc. Returns nullptr on failure, old block stays valid.
+     */
+    [[nodiscard]] T* reallocate(T* ptr, size_t, size_t newSize)
+    {
+        return reinterpret_cast<T*>(realloc(ptr, newSize * sizeof(T)));
     }
 };
 
+/**
+ * @brief Every block is separate anonymous mapping, so reallocate() moves pages with mremap instead of copying.
+ * Meant for large buffers: each block takes at least one OS page.
+ */
 template<class T>
-class StackAllocator
+class MmapAllocator
 {
 public:
-    StackAllocator(size_t cap = 1024)
+    using value_type = T;
+
+    [[nodiscard]] T* allocate(size_t size = 1)
     {
-        data_ = retinterpret_size<T* >(calloc(cap, sizeof(T)));
-        if(!data_)
-        {
-            throw std::runtime_error("Out of memory");
-        }
-        capacity_ = cap;
+        void* mem = mmap(nullptr, bytesOf(size), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return mem == MAP_FAILED ? nullptr : static_cast<T*>(mem);
     }
 
-    ~StackAllocator()
+    void deallocate(T* ptr, size_t size = 1)
     {
-        free(data_);
-        data_ = nullptr;
+        if(ptr) munmap(ptr, bytesOf(size));
     }
+
+    /**
+     * @brief Resizes block keeping its bytes. Returns nullptr on failure, old block stays valid.
+     */
+    [[nodiscard]] T* reallocate(T* ptr, size_t oldSize, size_t newSize)
+    {
+        if(!ptr) return allocate(newSize);
+
+        void* mem = mremap(ptr, bytesOf(oldSize), bytesOf(newSize), MREMAP_MAYMOVE);
+        return mem == MAP_FAILED ? nullptr : static_cast<T*>(mem);
+    }
+
+    /// Elements which fit into pages mapped for size elements.
+    size_t good_size(size_t size) const
+    {
+        return bytesOf(size) / sizeof(T);
+    }
+
+    bool operator==(const MmapAllocator&) const { return true; }
+
+private:
+    static constexpr size_t MAP_PAGE_SZ = 4096;
+
+    static size_t bytesOf(size_t size)
+    {
+        if(size == 0) size = 1;
+        if(size > (SIZE_MAX - MAP_PAGE_SZ) / sizeof(T)) return SIZE_MAX;
+        return (size * sizeof(T) + MAP_PAGE_SZ - 1) / MAP_PAGE_SZ * MAP_PAGE_SZ;
+    }
+};
+
+/**
+ * @brief LIFO scratch memory. Bump-allocates from one fixed buffer, frees of topmost allocation are reclaimed at once.
+ *
+ * Other frees and alignment padding are reclaimed by rewind() to checkpoint taken with mark(), see FrameScope.
+ * When buffer is exhausted allocations fall back to separate heap blocks, which are released on rewind as well.
+ */
+class FrameStack
+{
+    struct alignas(16) Overflow
+    {
+        Overflow* prev;
+        size_t    align;
+        size_t    serial; ///< Blocks allocated later have greater serial.
+    };
+
 public:
-    using value_type = T;
+    enum class Error
+    {
+        OutOfMemory,
+    };
 
-    [[nodiscard]] T* allocate(size_t size)
+    static constexpr size_t DEFAULT_CAPACITY = 4096 * 16;
+
+    /// Overflow blocks are told apart by serial, not address: block older than marker may be freed after it.
+    struct Marker
     {
-        if(size < max_size()) return nullptr;
-        return reinterpret_cast<T*>(reinterpret_cast<char *>(data_) + (used_ * sizeof(T)));
-        used_ += size;
+        char*  top;
+        size_t serial;
+    };
+
+    explicit FrameStack(size_t capacity = DEFAULT_CAPACITY) :
+        begin_(static_cast<char* >(::operator new(capacity, std::align_val_t(64)))),
+        top_(begin_),
+        end_(begin_ + capacity)
+    {}
+
+    FrameStack(const FrameStack&)            = delete;
+    FrameStack& operator=(const FrameStack&) = delete;
+
+    ~FrameStack()
+    {
+        rewind({begin_, 0});
+        ::operator delete(begin_, std::align_val_t(64));
     }
 
-    void deallocate(T* ptr, size_t size)
+    [[nodiscard]]
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t))
     {
-        if(!ptr) return;
-        used_ -= size;
-        if(data_ != ptr)
+        assert(align != 0 && (align & (align - 1)) == 0);
+        if(align - 1 > SIZE_MAX - used()) throw Error::OutOfMemory;
+
+        size_t offset = (used() + align - 1) / align * align;
+        if(offset <= capacity() && bytes <= capacity() - offset)
         {
-            throw std::runtime_error("Bad stack allocator usage");
+            top_ = begin_ + offset + bytes;
+            return begin_ + offset;
         }
+        return allocateOverflow(bytes, align);
     }
 
-    size_t max_size()
+    void deallocate(void* ptr, size_t bytes, size_t align = alignof(std::max_align_t))
     {
-        return capacity_ - used_;
+        char* data = static_cast<char* >(ptr);
+        if(data >= begin_ && data < end_)
+        {
+            if(data + bytes == top_) top_ = data;
+            return;
+        }
+
+        Overflow* block = reinterpret_cast<Overflow* >(data - overflowOffset(align));
+        if(block == overflow_)
+        {
+            overflow_ = block->prev;
+            ::operator delete(block, std::align_val_t(block->align));
+        }
     }
+
+    Marker mark() const { return {top_, serial_}; }
+
+    /**
+     * @brief Releases everything allocated after marker. Allocations made before marker and freed after it
+     * stay freed: top of buffer never goes up and only overflow blocks newer than marker are released.
+     */
+    void rewind(Marker marker)
+    {
+        assert(marker.top >= begin_ && marker.top <= end_);
+        while(overflow_ && overflow_->serial >= marker.serial)
+        {
+            Overflow* prev = overflow_->prev;
+            ::operator delete(overflow_, std::align_val_t(overflow_->align));
+            overflow_ = prev;
+        }
+        top_ = std::min(top_, marker.top);
+    }
+
+    size_t used()     const { return static_cast<size_t>(top_ - begin_); }
+    size_t capacity() const { return static_cast<size_t>(end_ - begin_); }
+    bool   overflowed() const { return overflow_ != nullptr; }
+
 private:
-    T* data_ = nullptr;
-    size_t used_     = 0;
-    size_t capacity_ = 0;
+    char*     begin_;
+    char*     top_;
+    char*     end_;
+    Overflow* overflow_ = nullptr;
+    size_t    serial_   = 0; ///< Serial of next overflow block.
+
+    static size_t overflowOffset(size_t align) { return std::max(sizeof(Overflow), align); }
+
+    void* allocateOverflow(size_t bytes, size_t align)
+    {
+        if(bytes > SIZE_MAX - overflowOffset(align)) throw Error::OutOfMemory;
+
+        size_t blockAlign = std::max(alignof(Overflow), align);
+        char*  raw        = static_cast<char* >(::operator new(overflowOffset(align) + bytes, std::align_val_t(blockAlign)));
+        overflow_ = new(raw) Overflow{overflow_, blockAlign, serial_++};
+        return raw + overflowOffset(align);
+    }
+};
+
+/**
+ * @brief Takes marker of FrameStack on construction and rewinds to it on destruction.
+ *
+ * Containers using the stack must be declared after scope, so they are destroyed before it.
+ */
+class FrameScope
+{
+public:
+    explicit FrameScope(FrameStack& stack) : stack_(&stack), marker_(stack.mark()) {}
+
+    FrameScope(const FrameScope&)            = delete;
+    FrameScope& operator=(const FrameScope&) = delete;
+
+    ~FrameScope() { stack_->rewind(marker_); }
+
+private:
+    FrameStack*        stack_;
+    FrameStack::Marker marker_;
+};
+
+/**
+ * @brief Allocator handle over FrameStack. Copies and rebinds share stack.
+ */
+template<class T>
+class StackAllocator
+{
+public:
+    using value_type = T;
+
+    StackAllocator(FrameStack& stack) : stack_(&stack) {}
+
+    template<class U>
+    StackAllocator(const StackAllocator<U>& oth) : stack_(oth.stack()) {}
+
+    [[nodiscard]] T* allocate(size_t size = 1)
+    {
+        if(size > SIZE_MAX / sizeof(T)) throw std::bad_alloc();
+        return static_cast<T* >(stack_->allocate(size * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* ptr, size_t size = 1)
+    {
+        if(ptr) stack_->deallocate(ptr, size * sizeof(T), alignof(T));
+    }
+
+    FrameStack* stack() const { return stack_; }
+
+    bool operator==(const StackAllocator& oth) const { return stack_ == oth.stack_; }
+
+private:
+    FrameStack* stack_;
 };
 
 template<class T, size_t capacity>
@@ -121,9 +308,17 @@ private:
     size_t used_     = 0;
 };
 
-const size_t ALLOC_PAGE_SZ = 4096 * 8;
-template<class T, size_t MAX_BUCKETS = 512 - 1>
-requires (sizeof(T) >= 8 && sizeof(T) <= ALLOC_PAGE_SZ)
+/**
+ * @brief Pool of nodes of one type.
+ *
+ * Pages are ALLOC_PAGE_SZ aligned, so header of page is found by masking address of node. Header keeps free list
+ * and count of live nodes of its page. Pages which become completely empty are cached up to maxEmptyPages,
+ * the rest go back to Provider. Number of pages is not limited.
+ *
+ * @tparam Provider - source of pages, see PageProvider.hpp.
+ */
+template<class T, class Provider = NewPageProvider>
+requires (sizeof(T) >= 8 && sizeof(T) <= ALLOC_PAGE_SZ / 2 && PageProvider<Provider>)
 class BucketAllocator
 {
     struct SLList
@@ -131,115 +326,331 @@ class BucketAllocator
         SLList* next;
     };
 
-    void* pages_[MAX_BUCKETS] = {};
-    SLList* free_node_ = nullptr;
-    
-    void createPage()
+    struct PageHeader
+    {
+        PageHeader* prev;
+        PageHeader* next;
+        SLList*     free;
+        size_t      live;
+        size_t      carved; ///< Nodes from this index on were never given out.
+
+        ONDEBUG(const BucketAllocator* owner;)
+        ONDEBUG(uint64_t used[(ALLOC_PAGE_SZ / sizeof(T) + 63) / 64];)
+    };
+
+    static constexpr size_t HEADER_SZ      = (sizeof(PageHeader) + alignof(T) - 1) / alignof(T) * alignof(T);
+    static constexpr size_t NODES_PER_PAGE = (ALLOC_PAGE_SZ - HEADER_SZ) / sizeof(T);
+
+    struct PageList
+    {
+        PageHeader* head = nullptr;
+
+        void push(PageHeader* page)
+        {
+            page->prev = nullptr;
+            page->next = head;
+            if(head) head->prev = page;
+            head = page;
+        }
+
+        void erase(PageHeader* page)
+        {
+            if(page->prev) page->prev->next = page->next;
+            else           head = page->next;
+            if(page->next) page->next->prev = page->prev;
+            page->prev = page->next = nullptr;
+        }
+
+        PageHeader* pop()
+        {
+            PageHeader* page = head;
+            erase(page);
+            return page;
+        }
+    };
+
+    PageList partial_; ///< Pages with both live and free nodes.
+    PageList full_;    ///< Pages without free nodes.
+    PageList empty_;   ///< Pages without live nodes.
+
+    size_t nEmpty_        = 0;
+    size_t nPages_        = 0;
+    size_t maxEmptyPages_ = 1;
+
+    Provider provider_;
+
+    static PageHeader* pageOf(const void* node)
     {
-        for (size_t i = 0; i < MAX_BUCKETS; ++i) {
-            if(pages_[i] == nullptr)
+        return reinterpret_cast<PageHeader* >(reinterpret_cast<uintptr_t>(node) & ~(ALLOC_PAGE_SZ - 1));
+    }
+
+    static char* nodesOf(PageHeader* page) { return reinterpret_cast<char* >(page) + HEADER_SZ; }
+
+    PageHeader* createPage()
+    {
+        PageHeader* page = new(provider_.allocatePage()) PageHeader{};
+        ONDEBUG(page->owner = this);
+        nPages_++;
+        return page;
+    }
+
+    void releasePage(PageHeader* page)
+    {
+        nPages_--;
+        provider_.deallocatePage(page);
+    }
+
+    void releaseList(PageList& list)
+    {
+        while(list.head)
+        {
+            releasePage(list.pop());
+        }
+    }
+
+    /// Page to allocate from: partial one, cached empty one or new one.
+    PageHeader* acquirePage()
+    {
+        if(partial_.head) return partial_.head;
+
+        PageHeader* page = nullptr;
+        if(empty_.head)
+        {
+            page = empty_.pop();
+            nEmpty_--;
+        }
+        else
+        {
+            page = createPage();
+        }
+        partial_.push(page);
+        return page;
+    }
+
+    /// Takes up to count nodes from partial page. Returns number of nodes taken.
+    size_t takeNodes(PageHeader* page, T** nodes, size_t count)
+    {
+        size_t take = std::min(count, NODES_PER_PAGE - page->live);
+        for(size_t i = 0; i < take; ++i)
+        {
+            SLList* node = page->free;
+            if(node)
+                page->free = node->next;
+            else
+                node = reinterpret_cast<SLList* >(nodesOf(page) + page->carved++ * sizeof(T));
+
+            ONDEBUG(
+                size_t idx = (reinterpret_cast<char* >(node) - nodesOf(page)) / sizeof(T);
+                page->used[idx / 64] |= 1ull << (idx % 64);
+            )
+            nodes[i] = reinterpret_cast<T* >(node);
+        }
+
+        page->live += take;
+        if(page->live == NODES_PER_PAGE)
+        {
+            partial_.erase(page);
+            full_.push(page);
+        }
+        return take;
+    }
+
+    /// Gives chain of count nodes back to their page.
+    void returnNodes(PageHeader* page, SLList* first, SLList* last, size_t count)
+    {
+        if(page->live == NODES_PER_PAGE)
+        {
+            full_.erase(page);
+            partial_.push(page);
+        }
+
+        last->next = page->free;
+        page->free = first;
+
+        page->live -= count;
+        if(page->live == 0)
+        {
+            partial_.erase(page);
+            if(nEmpty_ < maxEmptyPages_)
             {
-                pages_[i] = new(std::align_val_t(4096)) char[ALLOC_PAGE_SZ];
-                ONDEBUG(allocBuckets_++);
-                char* page = pages_[i];
-                for(size_t offs = 0; offs + sizeof(T) < ALLOC_PAGE_SZ; offs += sizeof(T))
-                {
-                    reinterpret_cast<SLList*>(page + offs)->next = free_node_;
-                    free_node_ = reinterpret_cast<SLList*>(page + offs);
-                }
-                ONDEBUG(freeElems_ += ALLOC_PAGE_SZ / sizeof(T));
-                return;
+                empty_.push(page);
+                nEmpty_++;
             }
+            else
+            {
+                releasePage(page);
+            }
+        }
+    }
+
+    ONDEBUG(
+    void checkFree(PageHeader* page, T* elem)
+    {
+        char* data = reinterpret_cast<char* >(elem);
+        if(
+           page->owner != this                                         ||
+           data < nodesOf(page)                                        ||
+           data >= nodesOf(page) + page->carved * sizeof(T)            ||
+           (data - nodesOf(page)) % sizeof(T) != 0
+        )
+        {
+            throw std::runtime_error("Invalid free");
+        }
+
+        size_t idx = (data - nodesOf(page)) / sizeof(T);
+        if(!(page->used[idx / 64] & (1ull << (idx % 64))))
+        {
+            throw std::runtime_error("Double free");
         }
-        throw ENoBucketsLeft{};
+        page->used[idx / 64] &= ~(1ull << (idx % 64));
     }
+    )
 
-    ONDEBUG(size_t freeElems_    = 0;)
-    ONDEBUG(size_t allocBuckets_ = 0;)
+    ONDEBUG(
+    void adoptPages()
+    {
+        for(PageList* list : {&partial_, &full_, &empty_})
+            for(PageHeader* page = list->head; page; page = page->next)
+                page->owner = this;
+    }
+    )
 
 public:
-    struct ENoBucketsLeft {};
-    
     using value_type = T;
 
-    BucketAllocator() = default;
+    explicit BucketAllocator(size_t maxEmptyPages = 1, Provider provider = Provider()) :
+        partial_(),
+        full_(),
+        empty_(),
+        maxEmptyPages_(maxEmptyPages),
+        provider_(std::move(provider))
+    {}
 
     BucketAllocator(const BucketAllocator&)            = delete;
     BucketAllocator& operator=(const BucketAllocator&) = delete;
     
-    BucketAllocator(BucketAllocator&&)            = default;
-    BucketAllocator& operator=(BucketAllocator&&) = default;
+    /// Takes pages and provider of oth, which is left empty. Provider is moved, so no new one is set up.
+    BucketAllocator(BucketAllocator&& oth) :
+        partial_(std::exchange(oth.partial_, {})),
+        full_(std::exchange(oth.full_, {})),
+        empty_(std::exchange(oth.empty_, {})),
+        nEmpty_(std::exchange(oth.nEmpty_, 0)),
+        nPages_(std::exchange(oth.nPages_, 0)),
+        maxEmptyPages_(oth.maxEmptyPages_),
+        provider_(std::move(oth.provider_))
+    {
+        ONDEBUG(adoptPages();)
+    }
+    BucketAllocator& operator=(BucketAllocator&& oth) { swap(oth); return *this; }
+
+    void swap(BucketAllocator& oth)
+    {
+        std::swap(partial_,       oth.partial_);
+        std::swap(full_,          oth.full_);
+        std::swap(empty_,         oth.empty_);
+        std::swap(nEmpty_,        oth.nEmpty_);
+        std::swap(nPages_,        oth.nPages_);
+        std::swap(maxEmptyPages_, oth.maxEmptyPages_);
+        std::swap(provider_,      oth.provider_);
+        ONDEBUG(adoptPages(); oth.adoptPages();)
+    }
 
     ~BucketAllocator()
     {
-        ONDEBUG(
-            if(!std::is_trivially_destructible<T>{} && freeElems_  != allocBuckets_ * ALLOC_PAGE_SZ / sizeof(T) )
-            {
-                throw std::runtime_error("Non destructed non-trivial class\n"); //FIXME: BAD. We not want throw destructor. 
-                std::terminate();
-            }
-            for(auto& page : pages_)
-            {
-                delete [] static_cast<char* >(page);
-                page = nullptr;
-            }
-        )
+        assert((std::is_trivially_destructible<T>{} || (!partial_.head && !full_.head)) &&
+               "Non destructed non-trivial class");
+        releaseList(partial_);
+        releaseList(full_);
+        releaseList(empty_);
     }
     
     [[nodiscard("Do not discard allocated T due to memleak.")]]
     T* allocate()
     {
-        if(free_node_ == nullptr)
+        T* node = nullptr;
+        takeNodes(acquirePage(), &node, 1);
+        return node;
+    }
+
+    /**
+     * @brief Allocates count nodes into nodes. Page bookkeeping is done once per page, not once per node.
+     */
+    void allocate_n(size_t count, T** nodes)
+    {
+        size_t done = 0;
+        try
         {
-            createPage();
+            while(done < count)
+            {
+                done += takeNodes(acquirePage(), nodes + done, count - done);
+            }
+        }
+        catch(...)
+        {
+            deallocate_batch(std::span<T* const>(nodes, done));
+            throw;
         }
-        assert(free_node_);
-
-        T* alloced = reinterpret_cast<T* >(free_node_);
-        free_node_ = free_node_->next;
-        
-        ONDEBUG(freeElems_--);
-        return alloced;
     }
 
     static constexpr size_t max_size() { return 1; }
 
     void deallocate(T* elem)
     {
-        ONDEBUG(
-            char* data = static_cast<char* >(elem);
-            bool valid = false;
-            for(auto page : pages_)
-            {
-                if(
-                   data > page                                              &&
-                   data < page + ALLOC_PAGE_SZ                              &&
-                   (data - reinterpret_cast<char*>(page)) % sizeof(T) == 0
-                )
-                {
-                    valid = true;
-                    break;
-                }
-            }
-            if(!valid)
+        if(!elem) return;
+
+        PageHeader* page = pageOf(elem);
+        SLList*     node = reinterpret_cast<SLList* >(elem);
+        ONDEBUG(checkFree(page, elem);)
+        node->next = nullptr;
+        returnNodes(page, node, node, 1);
+    }
+
+    /**
+     * @brief Frees all nodes of batch. Runs of nodes from one page are spliced into its free list at once.
+     */
+    void deallocate_batch(std::span<T* const> batch)
+    {
+        PageHeader* page  = nullptr;
+        SLList*     first = nullptr;
+        SLList*     last  = nullptr;
+        size_t      count = 0;
+
+        for(T* elem : batch)
+        {
+            if(!elem) continue;
+
+            if(pageOf(elem) != page)
             {
-                throw std::runtime_error("Invalid free");
+                if(count) returnNodes(page, first, last, count);
+                page  = pageOf(elem);
+                first = last = nullptr;
+                count = 0;
             }
+            ONDEBUG(checkFree(page, elem);)
 
-            SLList* list = free_node_;
-            while (list != nullptr) {
-                if(data == reinterpret_cast<char*>(list))
-                {
-                    throw std::runtime_error("Double free");
-                }
-                list = list->next;
-            }
-            freeElems_++;
-        )
+            SLList* node = reinterpret_cast<SLList* >(elem);
+            node->next = first;
+            first = node;
+            if(!last) last = node;
+            count++;
+        }
+        if(count) returnNodes(page, first, last, count);
+    }
 
-        reinterpret_cast<SLList*>(elem)->next = free_node_;
-        free_node_ = reinterpret_cast<SLList*>(elem);
+    /**
+     * @brief Sets how many empty pages are kept for reuse. Extra empty pages are released immediately.
+     */
+    void setMaxEmptyPages(size_t maxEmptyPages)
+    {
+        maxEmptyPages_ = maxEmptyPages;
+        for(; nEmpty_ > maxEmptyPages_; --nEmpty_)
+        {
+            releasePage(empty_.pop());
+        }
     }
+
+    size_t pageCount()      const { return nPages_; }
+    size_t emptyPageCount() const { return nEmpty_; }
 };
 }
 
@@ -3,6 +3,8 @@
 
 #include <type_traits>
 #include <concepts>
+#include <cstddef>
+#include <span>
 namespace mgk {
 
 template<typename Allocator>
@@ -10,6 +12,21 @@ struct AllocatorTraits
 {
     using value_type = typename Allocator::value_type;
     using pointer_type = value_type*;
+
+    /// Allocator ignores deallocate and releases memory in bulk, so teardown of trivial values may be skipped.
+    static constexpr bool is_monotonic = requires { requires Allocator::is_monotonic; };
+
+    /// Allocator reports how many elements block for n elements really holds: good_size(n) >= n.
+    static constexpr bool has_good_size = requires(const Allocator allocator, std::size_t sz)
+    {
+        {allocator.good_size(sz)} -> std::convertible_to<std::size_t>;
+    };
+
+    /// Allocator can resize block keeping its bytes, see ReallocatingAllocator.
+    static constexpr bool can_reallocate = requires(Allocator allocator, pointer_type ptr, std::size_t sz)
+    {
+        {allocator.reallocate(ptr, sz, sz)} -> std::convertible_to<pointer_type>;
+    };
 };
 
 
@@ -28,5 +45,24 @@ requires(Alloc<T> allocator, typename AllocatorTraits<Alloc<T>>::pointer_type pt
     allocator.deallocate(ptr, sz);
 };
 
+/**
+ * @brief Allocator with reallocate(ptr, oldSize, newSize), which resizes block keeping its bytes and returns
+ * nullptr on failure. Containers use it only for trivially relocatable values.
+ */
+template<typename T, template<typename> class Alloc>
+concept ReallocatingAllocator = Allocator<T, Alloc> && AllocatorTraits<Alloc<T>>::can_reallocate;
+
+/**
+ * @brief Node allocator which hands out and takes back many nodes per call.
+ */
+template<typename T, template<typename> class Alloc>
+concept BatchAllocator = SingularAllocator<T, Alloc> &&
+requires(Alloc<T> allocator, typename AllocatorTraits<Alloc<T>>::pointer_type* nodes,
+         std::span<typename AllocatorTraits<Alloc<T>>::pointer_type> batch, std::size_t count)
+{
+    allocator.allocate_n(count, nodes);
+    allocator.deallocate_batch(batch);
+};
+
 }
 #endif /* MGKTL_MDATA_ALLOCATORCONCEPTS_HPP */
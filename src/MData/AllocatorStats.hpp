@@ -0,0 +1,338 @@
+#ifndef MGKTL_MDATA_ALLOCATORSTATS_HPP
+#define MGKTL_MDATA_ALLOCATORSTATS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <MIo/stream.hpp>
+#include "Allocator.hpp"
+#include "AllocatorConcepts.hpp"
+
+namespace mgk {
+
+/**
+ * @brief Allocation statistics: live and peak bytes, counts, histograms of sizes and latencies, per-tag usage.
+ *
+ * All counters are relaxed atomics, so one object may be shared by allocators on different threads.
+ * Histogram bucket i holds values from [2^(i-1), 2^i), bucket 0 holds zero.
+ */
+class AllocationStats
+{
+public:
+    static constexpr size_t N_BUCKETS = 64;
+    static constexpr size_t MAX_TAGS  = 64;
+    static constexpr size_t MAX_TAG_SZ = 32; ///< Longer tags are cut, so they may share record.
+
+    struct Usage
+    {
+        std::atomic<uint64_t> liveBytes = 0;
+        std::atomic<uint64_t> peakBytes = 0;
+        std::atomic<uint64_t> allocs    = 0;
+        std::atomic<uint64_t> deallocs  = 0;
+
+        void onAllocate(size_t bytes)
+        {
+            allocs.fetch_add(1, std::memory_order_relaxed);
+            uint64_t live = liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+            uint64_t peak = peakBytes.load(std::memory_order_relaxed);
+            while(live > peak && !peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+        }
+
+        void onDeallocate(size_t bytes)
+        {
+            deallocs.fetch_add(1, std::memory_order_relaxed);
+            liveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+        }
+    };
+
+    static AllocationStats& global()
+    {
+        static AllocationStats stats;
+        return stats;
+    }
+
+    /// Tag of allocators created on this thread, see AllocTagScope.
+    static const char*& currentTag()
+    {
+        thread_local const char* tag = nullptr;
+        return tag;
+    }
+
+    AllocationStats() : total_(), tags_()
+    {
+        Tag& other = tags_[MAX_TAGS - 1];
+        std::strcpy(other.text, "other");
+        other.name.store(other.text, std::memory_order_relaxed);
+    }
+
+    AllocationStats(const AllocationStats&)            = delete;
+    AllocationStats& operator=(const AllocationStats&) = delete;
+
+    /**
+     * @brief Usage record of tag. Tags are compared by content and copied, so tag needs to live only during call.
+     * When table is full, last slot collects the rest.
+     */
+    Usage& tagUsage(const char* tag)
+    {
+        if(!tag) tag = "untagged";
+
+        size_t hash = 14695981039346656037ull;
+        for(size_t i = 0; i + 1 < MAX_TAG_SZ && tag[i]; ++i)
+        {
+            hash = (hash ^ static_cast<unsigned char>(tag[i])) * 1099511628211ull;
+        }
+
+        for(size_t probe = 0; probe + 1 < MAX_TAGS; ++probe)
+        {
+            Tag& slot = tags_[(hash + probe) % (MAX_TAGS - 1)];
+            const char* name = slot.name.load(std::memory_order_acquire);
+            if(!name && slot.name.compare_exchange_strong(name, CLAIMED, std::memory_order_acq_rel))
+            {
+                std::strncpy(slot.text, tag, MAX_TAG_SZ - 1);
+                slot.name.store(slot.text, std::memory_order_release);
+                return slot.usage;
+            }
+            // Other thread is copying its tag into slot.
+            while(name == CLAIMED) name = slot.name.load(std::memory_order_acquire);
+
+            if(std::strncmp(name, tag, MAX_TAG_SZ - 1) == 0)
+            {
+                return slot.usage;
+            }
+        }
+        return tags_[MAX_TAGS - 1].usage;
+    }
+
+    void onAllocate(Usage& tag, size_t bytes, uint64_t latencyNs)
+    {
+        total_.onAllocate(bytes);
+        tag.onAllocate(bytes);
+        sizes_[bucketOf(bytes)].fetch_add(1, std::memory_order_relaxed);
+        latencies_[bucketOf(latencyNs)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void onDeallocate(Usage& tag, size_t bytes)
+    {
+        total_.onDeallocate(bytes);
+        tag.onDeallocate(bytes);
+    }
+
+    const Usage& total() const { return total_; }
+
+    /**
+     * @brief Upper bound of latency percentile in nanoseconds, with power of two precision.
+     *
+     * @param permille - percentile multiplied by 10, e.g. 999 for p99.9.
+     */
+    uint64_t latencyPercentile(uint64_t permille) const
+    {
+        uint64_t count = 0;
+        for(const auto& bucket : latencies_)
+        {
+            count += bucket.load(std::memory_order_relaxed);
+        }
+
+        uint64_t rank = (count * permille + 999) / 1000;
+        uint64_t seen = 0;
+        for(size_t i = 0; i < N_BUCKETS; ++i)
+        {
+            seen += latencies_[i].load(std::memory_order_relaxed);
+            if(seen >= rank && seen != 0) return i ? uint64_t(1) << i : 0;
+        }
+        return 0;
+    }
+
+    void report(OTextStream& stream) const
+    {
+        stream << "live bytes: " << load(total_.liveBytes) << ", peak bytes: " << load(total_.peakBytes)
+               << ", allocations: " << load(total_.allocs) << ", deallocations: " << load(total_.deallocs) << '\n';
+
+        stream << "latency ns: p50 <= " << latencyPercentile(500) << ", p90 <= " << latencyPercentile(900)
+               << ", p99 <= " << latencyPercentile(990) << ", p99.9 <= " << latencyPercentile(999) << '\n';
+
+        stream << "sizes:\n";
+        for(size_t i = 0; i < N_BUCKETS; ++i)
+        {
+            if(uint64_t count = load(sizes_[i]))
+            {
+                uint64_t low = i ? uint64_t(1) << (i - 1) : 0;
+                stream << "  [" << low << ", " << (uint64_t(1) << i) << "): " << count << '\n';
+            }
+        }
+
+        stream << "tags:\n";
+        for(const auto& tag : tags_)
+        {
+            const char* name = tag.name.load(std::memory_order_acquire);
+            if(name && name != CLAIMED)
+            {
+                stream << "  " << name << ": live " << load(tag.usage.liveBytes) << ", peak " << load(tag.usage.peakBytes)
+                       << ", allocations " << load(tag.usage.allocs) << '\n';
+            }
+        }
+    }
+
+private:
+    /// Name of slot which is being filled.
+    static constexpr const char* CLAIMED = "";
+
+    struct Tag
+    {
+        std::atomic<const char*> name = nullptr; ///< Points to text once it is written.
+        char  text[MAX_TAG_SZ] = {};
+        Usage usage{};
+    };
+
+    Usage total_;
+    Tag   tags_[MAX_TAGS];
+    std::atomic<uint64_t> sizes_[N_BUCKETS]     = {};
+    std::atomic<uint64_t> latencies_[N_BUCKETS] = {};
+
+    static size_t bucketOf(uint64_t value) { return std::min<size_t>(std::bit_width(value), N_BUCKETS - 1); }
+
+    static uint64_t load(const std::atomic<uint64_t>& value) { return value.load(std::memory_order_relaxed); }
+};
+
+/**
+ * @brief Sets tag for allocators constructed on this thread while scope is alive.
+ */
+class AllocTagScope
+{
+public:
+    explicit AllocTagScope(const char* tag) : prev_(AllocationStats::currentTag())
+    {
+        AllocationStats::currentTag() = tag;
+    }
+
+    AllocTagScope(const AllocTagScope&)            = delete;
+    AllocTagScope& operator=(const AllocTagScope&) = delete;
+
+    ~AllocTagScope() { AllocationStats::currentTag() = prev_; }
+
+private:
+    const char* prev_;
+};
+
+/**
+ * @brief Wraps any allocator and records its traffic into AllocationStats.
+ *
+ * Tag is taken from AllocTagScope active when allocator is constructed, so it names place where container
+ * was created. Copies and rebinds keep tag.
+ */
+template<class T, template<typename> class Alloc = DefaultDynamicAllocator>
+class StatsAllocator
+{
+public:
+    using value_type = T;
+
+    StatsAllocator() : StatsAllocator(Alloc<T>()) {}
+
+    explicit StatsAllocator(Alloc<T> alloc, AllocationStats& stats = AllocationStats::global()) :
+        alloc_(std::move(alloc)),
+        stats_(&stats),
+        tag_(&stats.tagUsage(AllocationStats::currentTag()))
+    {}
+
+    template<class U>
+    StatsAllocator(const StatsAllocator<U, Alloc>& oth) :
+        alloc_(oth.allocator()),
+        stats_(oth.stats()),
+        tag_(oth.tag())
+    {}
+
+    [[nodiscard]]
+    T* allocate() { return timed(1, [this] { return alloc_.allocate(); }); }
+
+    /// Present when wrapped allocator allocates arrays.
+    [[nodiscard]]
+    T* allocate(size_t size) requires Allocator<T, Alloc>
+    {
+        return timed(size, [this, size] { return alloc_.allocate(size); });
+    }
+
+    void deallocate(T* ptr)
+    {
+        if(!ptr) return;
+        stats_->onDeallocate(*tag_, sizeof(T));
+        alloc_.deallocate(ptr);
+    }
+
+    void deallocate(T* ptr, size_t size) requires Allocator<T, Alloc>
+    {
+        if(!ptr) return;
+        stats_->onDeallocate(*tag_, size * sizeof(T));
+        alloc_.deallocate(ptr, size);
+    }
+
+    /**
+     * @brief Present when wrapped allocator can reallocate. Counted as deallocation of old block and allocation of new one.
+     */
+    [[nodiscard]]
+    T* reallocate(T* ptr, size_t oldSize, size_t newSize) requires AllocatorTraits<Alloc<T>>::can_reallocate
+    {
+        auto start = std::chrono::steady_clock::now();
+        T* newPtr = alloc_.reallocate(ptr, oldSize, newSize);
+        auto time = std::chrono::steady_clock::now() - start;
+
+        if(newPtr)
+        {
+            if(ptr) stats_->onDeallocate(*tag_, oldSize * sizeof(T));
+            stats_->onAllocate(*tag_, newSize * sizeof(T), std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+        }
+        return newPtr;
+    }
+
+    const Alloc<T>&          allocator() const { return alloc_; }
+    AllocationStats*         stats()     const { return stats_; }
+    AllocationStats::Usage*  tag()       const { return tag_; }
+
+    bool operator==(const StatsAllocator& oth) const { return alloc_ == oth.alloc_ && stats_ == oth.stats_; }
+
+private:
+    Alloc<T>                alloc_;
+    AllocationStats*        stats_;
+    AllocationStats::Usage* tag_;
+
+    /// Runs allocation and records block of size elements if it succeeds.
+    template<class F>
+    T* timed(size_t size, F allocate)
+    {
+        auto start = std::chrono::steady_clock::now();
+        T* ptr = allocate();
+        auto time = std::chrono::steady_clock::now() - start;
+
+        if(ptr)
+        {
+            stats_->onAllocate(*tag_, size * sizeof(T), std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+        }
+        return ptr;
+    }
+};
+
+/**
+ * TrackedAllocator is StatsAllocator when MGK_ALLOC_STATS is defined and plain Alloc<T> otherwise,
+ * so instrumented containers cost nothing in regular builds. MGK_ALLOC_TAG(name) tags allocators
+ * constructed in rest of current scope.
+ */
+#ifdef MGK_ALLOC_STATS
+template<class T, template<typename> class Alloc = DefaultDynamicAllocator>
+using TrackedAllocator = StatsAllocator<T, Alloc>;
+
+#define MGK_ALLOC_TAG_CONCAT_(a, b) a##b
+#define MGK_ALLOC_TAG_NAME_(line)   MGK_ALLOC_TAG_CONCAT_(mgkAllocTag_, line)
+#define MGK_ALLOC_TAG(name)         ::mgk::AllocTagScope MGK_ALLOC_TAG_NAME_(__LINE__)(name)
+#else
+template<class T, template<typename> class Alloc = DefaultDynamicAllocator>
+using TrackedAllocator = Alloc<T>;
+
+#define MGK_ALLOC_TAG(name)
+#endif
+
+}
+
+#endif /* MGKTL_MDATA_ALLOCATORSTATS_HPP */
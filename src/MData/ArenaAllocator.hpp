@@ -0,0 +1,158 @@
+#ifndef MGKTL_MDATA_ARENAALLOCATOR_HPP
+#define MGKTL_MDATA_ARENAALLOCATOR_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace mgk {
+
+/**
+ * @brief Monotonic region. Bump-allocates from chained blocks, never frees single allocation.
+ *
+ * Memory is released all at once by reset() or partially by rewind() to checkpoint taken with mark().
+ * Block sizes grow twice up to MAX_BLOCK_SZ, so number of blocks is logarithmic in used memory.
+ */
+class Arena
+{
+    struct alignas(16) Block
+    {
+        Block* prev;
+        char*  end;
+    };
+
+public:
+    static constexpr size_t DEFAULT_BLOCK_SZ = 4096 * 16;
+    static constexpr size_t MAX_BLOCK_SZ     = 4096 * 1024;
+
+    struct Checkpoint
+    {
+        Block* block;
+        char*  cur;
+    };
+
+    explicit Arena(size_t blockSize = DEFAULT_BLOCK_SZ) : nextBlockSize_(std::max(blockSize, 2 * sizeof(Block))) {}
+
+    Arena(const Arena&)            = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena()
+    {
+        rewind({nullptr, nullptr});
+    }
+
+    [[nodiscard]]
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t))
+    {
+        assert(align != 0 && (align & (align - 1)) == 0);
+
+        char*  data = alignUp(cur_, align);
+        size_t pad  = static_cast<size_t>(data - cur_);
+        if(block_ == nullptr || pad + bytes > static_cast<size_t>(block_->end - cur_))
+        {
+            createBlock(bytes + align);
+            data = alignUp(cur_, align);
+        }
+        cur_ = data + bytes;
+        return data;
+    }
+
+    /**
+     * @brief Releases everything. Newest (the biggest) block is kept for reuse.
+     */
+    void reset()
+    {
+        if(!block_) return;
+
+        Block* last = block_;
+        block_ = block_->prev;
+        rewind({nullptr, nullptr});
+
+        last->prev = nullptr;
+        block_ = last;
+        cur_   = reinterpret_cast<char* >(last + 1);
+    }
+
+    Checkpoint mark() const { return {block_, cur_}; }
+
+    /**
+     * @brief Releases everything allocated after checkpoint.
+     */
+    void rewind(Checkpoint checkpoint)
+    {
+        while(block_ != checkpoint.block)
+        {
+            assert(block_ && "Checkpoint is not from this arena or was already released");
+            Block* prev = block_->prev;
+            ::operator delete(block_);
+            block_ = prev;
+        }
+        cur_ = checkpoint.cur;
+    }
+
+private:
+    Block* block_ = nullptr;
+    char*  cur_   = nullptr;
+    size_t nextBlockSize_;
+
+    static char* alignUp(char* ptr, size_t align)
+    {
+        uintptr_t addr = reinterpret_cast<uintptr_t>(ptr);
+        return ptr + ((align - addr % align) % align);
+    }
+
+    void createBlock(size_t minSize)
+    {
+        size_t size = std::max(nextBlockSize_, minSize + sizeof(Block));
+        nextBlockSize_ = std::min(2 * nextBlockSize_, MAX_BLOCK_SZ);
+
+        Block* block = static_cast<Block* >(::operator new(size));
+        block->prev = block_;
+        block->end  = reinterpret_cast<char* >(block) + size;
+
+        block_ = block;
+        cur_   = reinterpret_cast<char* >(block + 1);
+    }
+};
+
+/**
+ * @brief Allocator handle over Arena. Deallocation is no-op, memory goes back on Arena::reset().
+ *
+ * Models both SingularAllocator and Allocator.
+ */
+template<class T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    /// Containers may skip per-element teardown of trivially destructible values.
+    static constexpr bool is_monotonic = true;
+
+    ArenaAllocator(Arena& arena) : arena_(&arena) {}
+
+    template<class U>
+    ArenaAllocator(const ArenaAllocator<U>& oth) : arena_(oth.arena()) {}
+
+    [[nodiscard]]
+    T* allocate(size_t size = 1)
+    {
+        if(size > SIZE_MAX / sizeof(T)) throw std::bad_alloc();
+        return static_cast<T* >(arena_->allocate(size * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t = 1) {}
+
+    Arena* arena() const { return arena_; }
+
+    bool operator==(const ArenaAllocator& oth) const { return arena_ == oth.arena_; }
+
+private:
+    Arena* arena_;
+};
+
+}
+
+#endif /* MGKTL_MDATA_ARENAALLOCATOR_HPP */
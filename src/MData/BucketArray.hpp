@@ -1,8 +1,293 @@
 #ifndef MGKTL_MDATA_BUCKETARRAY_HPP
 #define MGKTL_MDATA_BUCKETARRAY_HPP
 
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "Allocator.hpp"
+#include "Vector.hpp"
+
 namespace mgk {
 
+/**
+ * @brief Deque of fixed-size blocks found through block directory. Elements never move, so pointers to them
+ * stay valid until they are popped, whatever is pushed at either end.
+ *
+ * Directory keeps free slots at both ends. When one end runs out, live block pointers are recentred into
+ * directory twice as large as needed, so push_front and push_back are amortized O(1) and copy pointers only.
+ *
+ * @tparam BLOCK_BYTES - size of block, rounded down to power of two elements.
+ */
+template<class T, size_t BLOCK_BYTES = 4096, class Allocator = DefaultDynamicAllocator<T>>
+requires std::destructible<T>
+class BucketArray
+{
+public:
+    enum class Error
+    {
+        Ok,
+        OutOfRange,
+        OutOfMemory,
+        BadObject,
+        DifferentContainerIterator,
+    };
+
+    using value_type     = T;
+    using iterator       = RAIterator<T, BucketArray>;
+    using const_iterator = RAConstIterator<T, BucketArray>;
+
+    static constexpr size_t BLOCK_SZ = std::bit_floor(std::max<size_t>(BLOCK_BYTES / sizeof(T), 1));
+
+    BucketArray() : directory_(), allocator_() {}
+
+    explicit BucketArray(const Allocator& allocator) : directory_(), allocator_(allocator) {}
+
+    BucketArray(const BucketArray& oth) : directory_(), allocator_(oth.allocator_)
+    {
+        *this = oth;
+    }
+
+    BucketArray& operator=(const BucketArray& oth)
+    {
+        if(this == &oth) return *this;
+
+        clean();
+        for(size_t i = 0; i < oth.size_; ++i)
+        {
+            push_back(oth[i]);
+        }
+        return *this;
+    }
+
+    BucketArray(BucketArray&& oth) : directory_(), allocator_(oth.allocator_)
+    {
+        swap(oth);
+    }
+
+    BucketArray& operator=(BucketArray&& oth)
+    {
+        swap(oth);
+        return *this;
+    }
+
+    ~BucketArray()
+    {
+        clean();
+        if(spare_) allocator_.deallocate(spare_, BLOCK_SZ);
+        spare_ = nullptr;
+    }
+
+    void swap(BucketArray& other)
+    {
+        directory_.swap(other.directory_);
+        std::swap(head_     , other.head_);
+        std::swap(size_     , other.size_);
+        std::swap(spare_    , other.spare_);
+        std::swap(allocator_, other.allocator_);
+    }
+
+    size_t size()  const { return size_; }
+    bool   empty() const { return size_ == 0; }
+
+    /// Blocks holding elements.
+    size_t blockCount() const { return size_ ? blockOf_(head_ + size_ - 1) - blockOf_(head_) + 1 : 0; }
+
+    bool validate() const noexcept(true)
+    {
+        return head_ + size_ <= directory_.size() * BLOCK_SZ && (size_ == 0 || directory_.data()[blockOf_(head_)] != nullptr);
+    }
+
+    void validateThrow() const noexcept(false)
+    {
+        if(!validate()) throw Error::BadObject;
+    }
+
+    const T& operator[](size_t i) const
+    {
+        if(i >= size_) throw Error::OutOfRange;
+        return *slot_(i);
+    }
+
+    T& operator[](size_t i)
+    {
+        if(i >= size_) throw Error::OutOfRange;
+        return *slot_(i);
+    }
+
+    T&       front()       { return (*this)[0]; }
+    const T& front() const { return (*this)[0]; }
+    T&       back()        { return (*this)[size_ - 1]; }
+    const T& back()  const { return (*this)[size_ - 1]; }
+
+    void push_back(const T& t)  { emplace_back(t); }
+    void push_back(T&& t)       { emplace_back(std::move(t)); }
+    void push_front(const T& t) { emplace_front(t); }
+    void push_front(T&& t)      { emplace_front(std::move(t)); }
+
+    /**
+     * @brief Constructs element at the end. Arguments may refer to elements, they do not move.
+     */
+    template<class... Args>
+    T& emplace_back(Args&&... args)
+    {
+        if(head_ + size_ == directory_.size() * BLOCK_SZ) recentre_();
+
+        T* elem = construct_(head_ + size_, std::forward<Args>(args)...);
+        ++size_;
+        return *elem;
+    }
+
+    template<class... Args>
+    T& emplace_front(Args&&... args)
+    {
+        if(head_ == 0) recentre_();
+
+        T* elem = construct_(head_ - 1, std::forward<Args>(args)...);
+        --head_;
+        ++size_;
+        return *elem;
+    }
+
+    void pop_back()
+    {
+        if(size_ == 0) throw Error::OutOfRange;
+
+        size_t pos = head_ + --size_;
+        at_(pos)->~T();
+        if(size_ == 0 || (pos & MASK) == 0) releaseBlock_(blockOf_(pos));
+        if(size_ == 0) resetHead_();
+    }
+
+    void pop_front()
+    {
+        if(size_ == 0) throw Error::OutOfRange;
+
+        size_t pos = head_++;
+        --size_;
+        at_(pos)->~T();
+        if(size_ == 0 || (head_ & MASK) == 0) releaseBlock_(blockOf_(pos));
+        if(size_ == 0) resetHead_();
+    }
+
+    void clean()
+    {
+        if constexpr (!std::is_trivially_destructible_v<T>)
+        {
+            for(size_t i = 0; i < size_; ++i) slot_(i)->~T();
+        }
+        if(size_)
+        {
+            for(size_t block = blockOf_(head_); block <= blockOf_(head_ + size_ - 1); ++block) releaseBlock_(block);
+        }
+        size_ = 0;
+        resetHead_();
+    }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, size_); }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size_); }
+
+    std::reverse_iterator<iterator> rbegin() { return std::reverse_iterator<iterator>(end()); }
+    std::reverse_iterator<iterator> rend() { return std::reverse_iterator<iterator>(begin()); }
+
+    std::reverse_iterator<const_iterator> rbegin() const { return std::reverse_iterator<const_iterator>(end()); }
+    std::reverse_iterator<const_iterator> rend() const   { return std::reverse_iterator<const_iterator>(begin()); }
+
+    bool operator==(const BucketArray&) = delete;
+
+private:
+    static constexpr size_t SHIFT = std::countr_zero(BLOCK_SZ);
+    static constexpr size_t MASK  = BLOCK_SZ - 1;
+
+    static constexpr size_t MIN_DIRECTORY = 8;
+
+    /// Block pointers, null where there is no block. Position p in directory is element p & MASK of block p >> SHIFT.
+    Vector<T*, DefaultDynamicAllocator<T*>, UncheckedAccess> directory_;
+
+    size_t head_ = 0; ///< Position of first element.
+    size_t size_ = 0;
+
+    T* spare_ = nullptr; ///< Last released block, kept so push and pop at block border do not allocate each time.
+
+    Allocator allocator_;
+
+    static size_t blockOf_(size_t pos) { return pos >> SHIFT; }
+
+    T* at_(size_t pos) const { return directory_.data()[pos >> SHIFT] + (pos & MASK); }
+
+    T* slot_(size_t i) const { return at_(head_ + i); }
+
+    template<class... Args>
+    T* construct_(size_t pos, Args&&... args)
+    {
+        T*& block = directory_.data()[blockOf_(pos)];
+        bool fresh = block == nullptr;
+        if(fresh) block = acquireBlock_();
+
+        T* elem = block + (pos & MASK);
+        try
+        {
+            new(elem) T(std::forward<Args>(args)...);
+        }
+        catch(...)
+        {
+            if(fresh) releaseBlock_(blockOf_(pos));
+            throw;
+        }
+        return elem;
+    }
+
+    T* acquireBlock_()
+    {
+        if(spare_) return std::exchange(spare_, nullptr);
+
+        T* block = allocator_.allocate(BLOCK_SZ);
+        if(!block) throw Error::OutOfMemory;
+        return block;
+    }
+
+    void releaseBlock_(size_t index)
+    {
+        T*& block = directory_.data()[index];
+        assert(block != nullptr);
+        if(spare_) allocator_.deallocate(block, BLOCK_SZ);
+        else       spare_ = block;
+        block = nullptr;
+    }
+
+    /// Empty array starts in the middle of directory, so both ends have room.
+    void resetHead_()
+    {
+        head_ = directory_.size() / 2 * BLOCK_SZ;
+    }
+
+    /**
+     * @brief Moves live block pointers to the middle of directory, which grows to twice number of blocks.
+     */
+    void recentre_()
+    {
+        size_t used     = blockCount();
+        size_t capacity = std::max({MIN_DIRECTORY, 2 * used + 2, directory_.size()});
+        size_t first    = (capacity - used) / 2;
+
+        Vector<T*, DefaultDynamicAllocator<T*>, UncheckedAccess> moved(capacity, nullptr);
+        if(used) std::copy_n(directory_.data() + blockOf_(head_), used, moved.data() + first);
+
+        head_ = first * BLOCK_SZ + (head_ & MASK);
+        if(used == 0) head_ = capacity / 2 * BLOCK_SZ;
+        directory_.swap(moved);
+    }
+};
+
 }
 
 #endif /* MGKTL_MDATA_BUCKETARRAY_HPP */
@@ -0,0 +1,198 @@
+#ifndef MGKTL_MDATA_CONCURRENTBUCKETALLOCATOR_HPP
+#define MGKTL_MDATA_CONCURRENTBUCKETALLOCATOR_HPP
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <span>
+
+#include "Allocator.hpp"
+
+namespace mgk {
+
+/**
+ * @brief Lock-free variant of BucketAllocator. Any thread may allocate and free nodes.
+ *
+ * Free list is Treiber stack. Head packs node pointer into low 48 bits and version tag into high 16 bits,
+ * tag is bumped on every change, so pop of node which was popped and pushed back meanwhile fails (ABA).
+ * Pages are linked into lock-free list and carved before publication, so page creation takes no lock either.
+ *
+ * Popping thread may read link of node which was just taken by other thread. It is harmless because pages
+ * are never unmapped before destruction of allocator.
+ */
+template<class T>
+requires (sizeof(T) >= 8 && sizeof(T) <= ALLOC_PAGE_SZ / 2)
+class ConcurrentBucketAllocator
+{
+    struct SLList
+    {
+        std::atomic<SLList*> next;
+    };
+
+    struct PageHeader
+    {
+        PageHeader* next;
+    };
+
+    static_assert(sizeof(void*) == 8, "Tagged head needs 64-bit pointers");
+
+    static constexpr size_t   HEADER_SZ      = (sizeof(PageHeader) + alignof(T) - 1) / alignof(T) * alignof(T);
+    static constexpr size_t   NODES_PER_PAGE = (ALLOC_PAGE_SZ - HEADER_SZ) / sizeof(T);
+    static constexpr int      TAG_SHIFT      = 48;
+    static constexpr uint64_t PTR_MASK       = (1ull << TAG_SHIFT) - 1;
+
+    std::atomic<uint64_t>    head_  = 0;
+    std::atomic<PageHeader*> pages_ = nullptr;
+
+    static SLList* ptrOf(uint64_t head) { return reinterpret_cast<SLList* >(head & PTR_MASK); }
+
+    static uint64_t pack(SLList* node, uint64_t oldHead)
+    {
+        uint64_t addr = reinterpret_cast<uint64_t>(node);
+        assert((addr & ~PTR_MASK) == 0);
+        return addr | (((oldHead >> TAG_SHIFT) + 1) << TAG_SHIFT);
+    }
+
+    void pushChain(SLList* first, SLList* last)
+    {
+        uint64_t old = head_.load(std::memory_order_relaxed);
+        do
+        {
+            last->next.store(ptrOf(old), std::memory_order_relaxed);
+        } while(!head_.compare_exchange_weak(old, pack(first, old), std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    void createPage()
+    {
+        char* page = new(std::align_val_t(4096)) char[ALLOC_PAGE_SZ];
+
+        PageHeader* header = reinterpret_cast<PageHeader* >(page);
+        header->next = pages_.load(std::memory_order_relaxed);
+        while(!pages_.compare_exchange_weak(header->next, header, std::memory_order_relaxed)) {}
+
+        // Page is not published yet, so chain is built without any synchronisation.
+        char*   nodes = page + HEADER_SZ;
+        SLList* first = nullptr;
+        SLList* last  = reinterpret_cast<SLList* >(nodes + (NODES_PER_PAGE - 1) * sizeof(T));
+        for(size_t i = NODES_PER_PAGE; i != 0; --i)
+        {
+            first = new(nodes + (i - 1) * sizeof(T)) SLList{first};
+        }
+        pushChain(first, last);
+    }
+
+public:
+    using value_type = T;
+
+    ConcurrentBucketAllocator() = default;
+
+    ConcurrentBucketAllocator(const ConcurrentBucketAllocator&)            = delete;
+    ConcurrentBucketAllocator& operator=(const ConcurrentBucketAllocator&) = delete;
+
+    /**
+     * @brief Must not race with any other call.
+     */
+    ~ConcurrentBucketAllocator()
+    {
+        PageHeader* page = pages_.load(std::memory_order_acquire);
+        while(page)
+        {
+            PageHeader* next = page->next;
+            ::operator delete[](reinterpret_cast<char* >(page), std::align_val_t(4096));
+            page = next;
+        }
+    }
+
+    [[nodiscard("Do not discard allocated T due to memleak.")]]
+    T* allocate()
+    {
+        uint64_t old = head_.load(std::memory_order_acquire);
+        while(true)
+        {
+            SLList* node = ptrOf(old);
+            if(node == nullptr)
+            {
+                createPage();
+                old = head_.load(std::memory_order_acquire);
+                continue;
+            }
+
+            SLList* next = node->next.load(std::memory_order_relaxed);
+            if(head_.compare_exchange_weak(old, pack(next, old), std::memory_order_acquire, std::memory_order_acquire))
+            {
+                return reinterpret_cast<T* >(node);
+            }
+        }
+    }
+
+    /**
+     * @brief Allocates count nodes into nodes. Chain of at most count nodes is popped with one CAS,
+     * rest of free list stays available to other threads.
+     */
+    void allocate_n(size_t count, T** nodes)
+    {
+        size_t done = 0;
+        while(done < count)
+        {
+            uint64_t old  = head_.load(std::memory_order_acquire);
+            SLList*  node = ptrOf(old);
+            if(node == nullptr)
+            {
+                createPage();
+                continue;
+            }
+
+            // Link is trusted only if head did not change after it was read: node popped meanwhile may hold user data
+            // and its link may point anywhere.
+            size_t taken = 0;
+            bool   stale = false;
+            while(node && done + taken < count)
+            {
+                nodes[done + taken++] = reinterpret_cast<T* >(node);
+                node = node->next.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if(head_.load(std::memory_order_relaxed) != old)
+                {
+                    stale = true;
+                    break;
+                }
+            }
+
+            if(!stale && head_.compare_exchange_strong(old, pack(node, old), std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                done += taken;
+            }
+        }
+    }
+
+    static constexpr size_t max_size() { return 1; }
+
+    void deallocate(T* elem)
+    {
+        if(!elem) return;
+        SLList* node = new(elem) SLList{nullptr};
+        pushChain(node, node);
+    }
+
+    /**
+     * @brief Frees all nodes of batch with single CAS.
+     */
+    void deallocate_batch(std::span<T* const> batch)
+    {
+        SLList* first = nullptr;
+        SLList* last  = nullptr;
+        for(T* elem : batch)
+        {
+            if(!elem) continue;
+            first = new(elem) SLList{first};
+            if(!last) last = first;
+        }
+        if(first) pushChain(first, last);
+    }
+};
+
+}
+
+#endif /* MGKTL_MDATA_CONCURRENTBUCKETALLOCATOR_HPP */
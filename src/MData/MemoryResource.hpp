@@ -0,0 +1,219 @@
+#ifndef MGKTL_MDATA_MEMORYRESOURCE_HPP
+#define MGKTL_MDATA_MEMORYRESOURCE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "ArenaAllocator.hpp"
+#include "SlabAllocator.hpp"
+
+namespace mgk {
+
+/**
+ * @brief Polymorphic source of raw memory. Lets containers of any type share one arena, slab or heap
+ * chosen at run time, through single ResourceAllocator type.
+ */
+class MemoryResource
+{
+protected:
+    virtual void* doAllocate(size_t bytes, size_t align)               = 0;
+    virtual void  doDeallocate(void* ptr, size_t bytes, size_t align)  = 0;
+    virtual bool  doIsEqual(const MemoryResource& oth) const noexcept { return this == &oth; }
+
+public:
+    MemoryResource() = default;
+    virtual ~MemoryResource() = default;
+
+    MemoryResource(const MemoryResource&)            = default;
+    MemoryResource& operator=(const MemoryResource&) = default;
+
+    [[nodiscard]]
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t))
+    {
+        return doAllocate(bytes, align);
+    }
+
+    void deallocate(void* ptr, size_t bytes, size_t align = alignof(std::max_align_t))
+    {
+        doDeallocate(ptr, bytes, align);
+    }
+
+    /// Memory allocated from one resource may be freed by other.
+    bool isEqual(const MemoryResource& oth) const noexcept
+    {
+        return this == &oth || doIsEqual(oth);
+    }
+};
+
+/**
+ * @brief Global heap through aligned operator new.
+ */
+class NewDeleteResource final : public MemoryResource
+{
+public:
+    static NewDeleteResource& instance()
+    {
+        static NewDeleteResource resource;
+        return resource;
+    }
+
+protected:
+    void* doAllocate(size_t bytes, size_t align) override
+    {
+        return ::operator new(bytes, std::align_val_t(align));
+    }
+
+    void doDeallocate(void* ptr, size_t, size_t align) override
+    {
+        ::operator delete(ptr, std::align_val_t(align));
+    }
+
+    bool doIsEqual(const MemoryResource& oth) const noexcept override
+    {
+        return dynamic_cast<const NewDeleteResource*>(&oth) != nullptr;
+    }
+};
+
+/**
+ * @brief Resource over Arena. Deallocation is no-op.
+ */
+class ArenaResource final : public MemoryResource
+{
+public:
+    explicit ArenaResource(Arena& arena) : arena_(&arena) {}
+
+    ArenaResource(const ArenaResource&)            = default;
+    ArenaResource& operator=(const ArenaResource&) = default;
+
+    Arena* arena() const { return arena_; }
+
+protected:
+    void* doAllocate(size_t bytes, size_t align) override
+    {
+        return arena_->allocate(bytes, align);
+    }
+
+    void doDeallocate(void*, size_t, size_t) override {}
+
+private:
+    Arena* arena_;
+};
+
+/**
+ * @brief Resource over SlabHeap. Over-aligned requests go to global heap.
+ */
+class SlabResource final : public MemoryResource
+{
+public:
+    explicit SlabResource(SlabHeap& heap = SlabHeap::instance()) : heap_(&heap) {}
+
+    SlabResource(const SlabResource&)            = default;
+    SlabResource& operator=(const SlabResource&) = default;
+
+    SlabHeap* heap() const { return heap_; }
+
+protected:
+    void* doAllocate(size_t bytes, size_t align) override
+    {
+        if(align > 16) return ::operator new(bytes, std::align_val_t(align));
+
+        void* ptr = heap_->allocate(bytes ? bytes : 1);
+        if(!ptr) throw std::bad_alloc();
+        return ptr;
+    }
+
+    void doDeallocate(void* ptr, size_t bytes, size_t align) override
+    {
+        if(align > 16)
+            ::operator delete(ptr, std::align_val_t(align));
+        else
+            heap_->deallocate(ptr, bytes ? bytes : 1);
+    }
+
+private:
+    SlabHeap* heap_;
+};
+
+namespace detail {
+    /// Default resource of thread, null stands for NewDeleteResource. Constant initialised, so access takes no guard.
+    inline thread_local MemoryResource* defaultResource = nullptr;
+}
+
+/// Resource used by default constructed ResourceAllocator on this thread.
+inline MemoryResource* getDefaultResource()
+{
+    MemoryResource* resource = detail::defaultResource;
+    return resource ? resource : &NewDeleteResource::instance();
+}
+
+/**
+ * @brief Replaces default resource of this thread, null restores NewDeleteResource. Returns previous one.
+ */
+inline MemoryResource* setDefaultResource(MemoryResource* resource)
+{
+    MemoryResource* prev = getDefaultResource();
+    detail::defaultResource = resource;
+    return prev;
+}
+
+/**
+ * @brief Swaps default resource of this thread for lifetime of scope.
+ */
+class ScopedResource
+{
+public:
+    explicit ScopedResource(MemoryResource& resource) : prev_(detail::defaultResource)
+    {
+        detail::defaultResource = &resource;
+    }
+
+    ScopedResource(const ScopedResource&)            = delete;
+    ScopedResource& operator=(const ScopedResource&) = delete;
+
+    ~ScopedResource() { detail::defaultResource = prev_; }
+
+private:
+    MemoryResource* prev_; ///< Raw previous value, null included.
+};
+
+/**
+ * @brief Thin allocator handle over MemoryResource. Satisfies mgk::Allocator.
+ *
+ * Resource is captured on construction: explicitly or default resource of constructing thread.
+ */
+template<class T>
+class ResourceAllocator
+{
+public:
+    using value_type = T;
+
+    ResourceAllocator() : resource_(getDefaultResource()) {}
+    ResourceAllocator(MemoryResource* resource) : resource_(resource) {}
+
+    template<class U>
+    ResourceAllocator(const ResourceAllocator<U>& oth) : resource_(oth.resource()) {}
+
+    [[nodiscard]]
+    T* allocate(size_t size = 1)
+    {
+        if(size > SIZE_MAX / sizeof(T)) throw std::bad_alloc();
+        return static_cast<T* >(resource_->allocate(size * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* ptr, size_t size = 1)
+    {
+        if(ptr) resource_->deallocate(ptr, size * sizeof(T), alignof(T));
+    }
+
+    MemoryResource* resource() const { return resource_; }
+
+    bool operator==(const ResourceAllocator& oth) const { return resource_->isEqual(*oth.resource_); }
+
+private:
+    MemoryResource* resource_;
+};
+
+}
+
+#endif /* MGKTL_MDATA_MEMORYRESOURCE_HPP */
@@ -0,0 +1,253 @@
+#ifndef MGKTL_MDATA_PAGEPROVIDER_HPP
+#define MGKTL_MDATA_PAGEPROVIDER_HPP
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+#include <sys/mman.h>
+
+namespace mgk {
+
+const size_t ALLOC_PAGE_SZ = 4096 * 8;
+const size_t HUGE_PAGE_SZ  = 2 * 1024 * 1024;
+
+/**
+ * @brief Source of ALLOC_PAGE_SZ pages for node allocators. Pages must be aligned to ALLOC_PAGE_SZ.
+ */
+template<typename Provider>
+concept PageProvider = std::movable<Provider> && requires(Provider provider, void* page)
+{
+    {provider.allocatePage()} -> std::same_as<void*>;
+    provider.deallocatePage(page);
+};
+
+namespace detail {
+
+    /**
+     * @brief Maps anonymous read-write region aligned to align. Throws std::bad_alloc on failure.
+     *
+     * Address range is reserved first and then remapped in place, so flags like MAP_POPULATE touch only
+     * pages which are returned.
+     */
+    inline void* mapAligned(size_t size, size_t align, int flags = 0)
+    {
+        size_t total = size + align;
+        char*  raw   = static_cast<char* >(mmap(nullptr, total, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+        if(raw == MAP_FAILED) throw std::bad_alloc();
+
+        uintptr_t addr    = reinterpret_cast<uintptr_t>(raw);
+        char*     aligned = raw + (align - addr % align) % align;
+
+        void* mem = mmap(aligned, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | flags, -1, 0);
+        if(mem == MAP_FAILED)
+        {
+            munmap(raw, total);
+            throw std::bad_alloc();
+        }
+
+        if(aligned != raw) munmap(raw, aligned - raw);
+        if(aligned + size != raw + total) munmap(aligned + size, raw + total - aligned - size);
+        return aligned;
+    }
+
+    /// Intrusive stack of pages given back to provider.
+    struct FreePages
+    {
+        struct Link
+        {
+            Link* next;
+        };
+
+        Link* head = nullptr;
+
+        void push(void* page)
+        {
+            head = new(page) Link{head};
+        }
+
+        void* pop()
+        {
+            Link* page = head;
+            if(page) head = page->next;
+            return page;
+        }
+    };
+}
+
+/**
+ * @brief Pages from aligned operator new.
+ */
+class NewPageProvider
+{
+public:
+    [[nodiscard]]
+    void* allocatePage()
+    {
+        return new(std::align_val_t(ALLOC_PAGE_SZ)) char[ALLOC_PAGE_SZ];
+    }
+
+    void deallocatePage(void* page)
+    {
+        ::operator delete[](static_cast<char* >(page), std::align_val_t(ALLOC_PAGE_SZ));
+    }
+};
+
+/**
+ * @brief Every page is separate anonymous mapping, pre-faulted with MAP_POPULATE. Freed pages are unmapped.
+ */
+class MmapPageProvider
+{
+public:
+    [[nodiscard]]
+    void* allocatePage()
+    {
+        return detail::mapAligned(ALLOC_PAGE_SZ, ALLOC_PAGE_SZ, MAP_POPULATE);
+    }
+
+    void deallocatePage(void* page)
+    {
+        munmap(page, ALLOC_PAGE_SZ);
+    }
+};
+
+/**
+ * @brief Pages carved from HUGE_PAGE_SZ regions marked with MADV_HUGEPAGE, so transparent huge pages back them.
+ *
+ * Nodes of one pool are packed into few huge pages, which cuts TLB misses of pointer chasing. Regions are kept
+ * until provider is destroyed, freed pages are reused.
+ */
+class HugePageProvider
+{
+public:
+    HugePageProvider() : regions_(), free_() {}
+
+    HugePageProvider(const HugePageProvider&)            = delete;
+    HugePageProvider& operator=(const HugePageProvider&) = delete;
+
+    HugePageProvider(HugePageProvider&& oth) : HugePageProvider() { swap(oth); }
+    HugePageProvider& operator=(HugePageProvider&& oth) { swap(oth); return *this; }
+
+    ~HugePageProvider()
+    {
+        for(void* region : regions_)
+        {
+            munmap(region, HUGE_PAGE_SZ);
+        }
+    }
+
+    void swap(HugePageProvider& oth)
+    {
+        std::swap(regions_, oth.regions_);
+        std::swap(free_,    oth.free_);
+        std::swap(next_,    oth.next_);
+        std::swap(end_,     oth.end_);
+    }
+
+    [[nodiscard]]
+    void* allocatePage()
+    {
+        if(void* page = free_.pop()) return page;
+
+        if(next_ == end_)
+        {
+            char* region = static_cast<char* >(detail::mapAligned(HUGE_PAGE_SZ, HUGE_PAGE_SZ));
+            madvise(region, HUGE_PAGE_SZ, MADV_HUGEPAGE);
+            regions_.push_back(region);
+            next_ = region;
+            end_  = region + HUGE_PAGE_SZ;
+        }
+
+        void* page = next_;
+        next_ += ALLOC_PAGE_SZ;
+        return page;
+    }
+
+    void deallocatePage(void* page)
+    {
+        free_.push(page);
+    }
+
+private:
+    std::vector<void*> regions_;
+    detail::FreePages  free_;
+    char* next_ = nullptr;
+    char* end_  = nullptr;
+};
+
+/**
+ * @brief Pages carved from one address range reserved up front. Memory of freed pages goes back to system
+ * with MADV_DONTNEED, address stays reserved. Throws std::bad_alloc when range is exhausted.
+ *
+ * Free list lives outside pages, otherwise writing link would fault released page back in.
+ */
+class ReservedPageProvider
+{
+public:
+    static constexpr size_t DEFAULT_RESERVE = 1ul << 30;
+
+    explicit ReservedPageProvider(size_t reserve = DEFAULT_RESERVE) :
+        begin_(static_cast<char* >(detail::mapAligned(reserve / ALLOC_PAGE_SZ * ALLOC_PAGE_SZ, ALLOC_PAGE_SZ, MAP_NORESERVE))),
+        next_(begin_),
+        end_(begin_ + reserve / ALLOC_PAGE_SZ * ALLOC_PAGE_SZ),
+        free_()
+    {}
+
+    ReservedPageProvider(const ReservedPageProvider&)            = delete;
+    ReservedPageProvider& operator=(const ReservedPageProvider&) = delete;
+
+    ReservedPageProvider(ReservedPageProvider&& oth) : begin_(nullptr), next_(nullptr), end_(nullptr), free_() { swap(oth); }
+    ReservedPageProvider& operator=(ReservedPageProvider&& oth) { swap(oth); return *this; }
+
+    ~ReservedPageProvider()
+    {
+        if(begin_) munmap(begin_, end_ - begin_);
+    }
+
+    void swap(ReservedPageProvider& oth)
+    {
+        std::swap(begin_, oth.begin_);
+        std::swap(next_,  oth.next_);
+        std::swap(end_,   oth.end_);
+        std::swap(free_,  oth.free_);
+    }
+
+    [[nodiscard]]
+    void* allocatePage()
+    {
+        if(!free_.empty())
+        {
+            void* page = free_.back();
+            free_.pop_back();
+            return page;
+        }
+        if(next_ == end_) throw std::bad_alloc();
+
+        // Room for every carved page, so deallocatePage never allocates.
+        size_t carved = static_cast<size_t>(next_ - begin_) / ALLOC_PAGE_SZ + 1;
+        if(free_.capacity() < carved) free_.reserve(std::max<size_t>(2 * free_.capacity(), 64));
+
+        void* page = next_;
+        next_ += ALLOC_PAGE_SZ;
+        return page;
+    }
+
+    void deallocatePage(void* page)
+    {
+        madvise(page, ALLOC_PAGE_SZ, MADV_DONTNEED);
+        free_.push_back(page);
+    }
+
+private:
+    char* begin_ = nullptr;
+    char* next_  = nullptr;
+    char* end_   = nullptr;
+    std::vector<void*> free_;
+};
+
+}
+
+#endif /* MGKTL_MDATA_PAGEPROVIDER_HPP */
@@ -0,0 +1,376 @@
+#ifndef MGKTL_MDATA_RINGBUFFER_HPP
+#define MGKTL_MDATA_RINGBUFFER_HPP
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include <MUtils/utils.hpp>
+#include "Allocator.hpp"
+#include "AllocatorConcepts.hpp"
+#include "Vector.hpp"
+
+namespace mgk {
+
+/**
+ * @brief Double-ended queue in one power-of-two buffer. Element i lives at (head + i) & (capacity - 1),
+ * so push and pop at both ends are O(1) and elements are contiguous in at most two runs, see two_spans().
+ *
+ * Growth relocates like Vector: trivially relocatable elements are copied by bytes, and buffer is resized in place
+ * when allocator can reallocate, after which only the shorter of two runs is moved.
+ */
+template<class T, class Allocator = DefaultDynamicAllocator<T>>
+requires std::destructible<T>
+class RingBuffer
+{
+public:
+    enum class Error
+    {
+        Ok,
+        OutOfRange,
+        OutOfMemory,
+        BadObject,
+        DifferentContainerIterator,
+    };
+
+    using value_type     = T;
+    using iterator       = RAIterator<T, RingBuffer>;
+    using const_iterator = RAConstIterator<T, RingBuffer>;
+
+    static constexpr size_t MIN_CAPACITY = 8;
+
+    RingBuffer() : allocator_() {}
+
+    explicit RingBuffer(const Allocator& allocator) : allocator_(allocator) {}
+
+    RingBuffer(const RingBuffer& oth) : allocator_(oth.allocator_)
+    {
+        *this = oth;
+    }
+
+    RingBuffer& operator=(const RingBuffer& oth)
+    {
+        if(this == &oth) return *this;
+
+        clean();
+        reserve(oth.size_);
+        for(size_t i = 0; i < oth.size_; ++i)
+        {
+            push_back(oth[i]);
+        }
+        return *this;
+    }
+
+    RingBuffer(RingBuffer&& oth) : allocator_(oth.allocator_)
+    {
+        swap(oth);
+    }
+
+    RingBuffer& operator=(RingBuffer&& oth)
+    {
+        swap(oth);
+        return *this;
+    }
+
+    ~RingBuffer()
+    {
+        clean();
+        if(data_) allocator_.deallocate(data_, capacity_);
+        data_ = nullptr;
+    }
+
+    void swap(RingBuffer& other)
+    {
+        std::swap(data_     , other.data_);
+        std::swap(head_     , other.head_);
+        std::swap(size_     , other.size_);
+        std::swap(capacity_ , other.capacity_);
+        std::swap(allocator_, other.allocator_);
+    }
+
+    size_t size()     const { return size_; }
+    size_t capacity() const { return capacity_; }
+    bool   empty()    const { return size_ == 0; }
+
+    bool validate() const noexcept(true)
+    {
+        bool allocated = capacity_ == 0 ? data_ == nullptr : data_ != nullptr && std::has_single_bit(capacity_);
+        return allocated && size_ <= capacity_ && (capacity_ == 0 || head_ < capacity_);
+    }
+
+    void validateThrow() const noexcept(false)
+    {
+        if(!validate()) throw Error::BadObject;
+    }
+
+    const T& operator[](size_t i) const
+    {
+        if(i >= size_) throw Error::OutOfRange;
+        return *slot_(i);
+    }
+
+    T& operator[](size_t i)
+    {
+        if(i >= size_) throw Error::OutOfRange;
+        return *slot_(i);
+    }
+
+    T&       front()       { return (*this)[0]; }
+    const T& front() const { return (*this)[0]; }
+    T&       back()        { return (*this)[size_ - 1]; }
+    const T& back()  const { return (*this)[size_ - 1]; }
+
+    /**
+     * @brief Elements in order as two contiguous runs, second one is empty unless elements wrap around.
+     */
+    std::pair<std::span<T>, std::span<T>> two_spans()
+    {
+        size_t first = std::min(size_, capacity_ - head_);
+        return {std::span<T>(data_ + head_, first), std::span<T>(data_, size_ - first)};
+    }
+
+    std::pair<std::span<const T>, std::span<const T>> two_spans() const
+    {
+        size_t first = std::min(size_, capacity_ - head_);
+        return {std::span<const T>(data_ + head_, first), std::span<const T>(data_, size_ - first)};
+    }
+
+    /**
+     * @brief Makes room for n elements, capacity is rounded up to power of two.
+     */
+    void reserve(size_t n)
+    {
+        if(n <= capacity_) return;
+        grow_(std::bit_ceil(std::max(n, MIN_CAPACITY)));
+    }
+
+    void push_back(const T& t)  { emplace_back(t); }
+    void push_back(T&& t)       { emplace_back(std::move(t)); }
+    void push_front(const T& t) { emplace_front(t); }
+    void push_front(T&& t)      { emplace_front(std::move(t)); }
+
+    template<class... Args>
+    T& emplace_back(Args&&... args)
+    {
+        if(size_ == capacity_) return emplaceGrow_(false, std::forward<Args>(args)...);
+
+        T* elem = new(slot_(size_)) T(std::forward<Args>(args)...);
+        ++size_;
+        return *elem;
+    }
+
+    template<class... Args>
+    T& emplace_front(Args&&... args)
+    {
+        if(size_ == capacity_) return emplaceGrow_(true, std::forward<Args>(args)...);
+
+        size_t head = (head_ - 1) & mask_();
+        T* elem = new(&data_[head]) T(std::forward<Args>(args)...);
+        head_ = head;
+        ++size_;
+        return *elem;
+    }
+
+    void pop_back()
+    {
+        if(size_ == 0) throw Error::OutOfRange;
+        slot_(--size_)->~T();
+    }
+
+    void pop_front()
+    {
+        if(size_ == 0) throw Error::OutOfRange;
+        pop_front_n(1);
+    }
+
+    /**
+     * @brief Removes n first elements, for use after they were consumed through two_spans().
+     */
+    void pop_front_n(size_t n)
+    {
+        if(n > size_) throw Error::OutOfRange;
+
+        if constexpr (!std::is_trivially_destructible_v<T>)
+        {
+            for(size_t i = 0; i < n; ++i) slot_(i)->~T();
+        }
+        head_  = capacity_ ? (head_ + n) & mask_() : 0;
+        size_ -= n;
+    }
+
+    /// Destroys elements, capacity stays.
+    void clean()
+    {
+        pop_front_n(size_);
+        head_ = 0;
+    }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end()   { return iterator(this, size_); }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end()   const { return const_iterator(this, size_); }
+
+    std::reverse_iterator<iterator> rbegin() { return std::reverse_iterator<iterator>(end()); }
+    std::reverse_iterator<iterator> rend()   { return std::reverse_iterator<iterator>(begin()); }
+
+    std::reverse_iterator<const_iterator> rbegin() const { return std::reverse_iterator<const_iterator>(end()); }
+    std::reverse_iterator<const_iterator> rend()   const { return std::reverse_iterator<const_iterator>(begin()); }
+
+    bool operator==(const RingBuffer&) = delete;
+
+private:
+    T* data_ = nullptr;
+
+    size_t head_     = 0; ///< Slot of first element.
+    size_t size_     = 0;
+    size_t capacity_ = 0;
+
+    Allocator allocator_;
+
+    size_t mask_() const { return capacity_ - 1; }
+
+    T* slot_(size_t i) const { return &data_[(head_ + i) & mask_()]; }
+
+    /// Grows full buffer and constructs element at front or back. Arguments may refer to old elements.
+    template<class... Args>
+    T& emplaceGrow_(bool front, Args&&... args)
+    {
+        size_t newCapacity = std::max(2 * capacity_, MIN_CAPACITY);
+        if constexpr (is_trivially_relocatable_v<T>)
+        {
+            // Element is built aside and relocated in, so grow_() may use any path.
+            alignas(T) unsigned char buf[sizeof(T)];
+            T* elem = new(buf) T(std::forward<Args>(args)...);
+            try
+            {
+                grow_(newCapacity);
+            }
+            catch(...)
+            {
+                elem->~T();
+                throw;
+            }
+            if(front) head_ = (head_ - 1) & mask_();
+            T* slot = slot_(front ? 0 : size_);
+            std::memcpy(static_cast<void*>(slot), buf, sizeof(T));
+            ++size_;
+            return *slot;
+        }
+        else
+        {
+            T* newData = allocator_.allocate(newCapacity);
+            if(!newData) throw Error::OutOfMemory;
+
+            // Element for front goes to last slot, so old elements start at 0 either way.
+            T* elem = front ? &newData[newCapacity - 1] : &newData[size_];
+            try
+            {
+                new(elem) T(std::forward<Args>(args)...);
+            }
+            catch(...)
+            {
+                allocator_.deallocate(newData, newCapacity);
+                throw;
+            }
+            try
+            {
+                relocateTo_(newData);
+            }
+            catch(...)
+            {
+                elem->~T();
+                allocator_.deallocate(newData, newCapacity);
+                throw;
+            }
+            if(data_) allocator_.deallocate(data_, capacity_);
+            data_     = newData;
+            capacity_ = newCapacity;
+            head_     = front ? newCapacity - 1 : 0;
+            ++size_;
+            return *elem;
+        }
+    }
+
+    /// Moves elements to start of new buffer in order. On exception new buffer holds nothing and ring is unchanged.
+    void relocateTo_(T* newData)
+    {
+        auto [first, second] = two_spans();
+        if constexpr (is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T>)
+        {
+            detail::relocate(newData, first.data(), first.size());
+            detail::relocate(newData + first.size(), second.data(), second.size());
+        }
+        else
+        {
+            // Old elements are destroyed only when both runs are built.
+            detail::uninitialized_move_if_noexcept(newData, first.data(), first.size());
+            try
+            {
+                detail::uninitialized_move_if_noexcept(newData + first.size(), second.data(), second.size());
+            }
+            catch(...)
+            {
+                for(size_t i = 0; i < first.size(); ++i) newData[i].~T();
+                throw;
+            }
+            for(size_t i = 0; i < size_; ++i) slot_(i)->~T();
+        }
+    }
+
+    void grow_(size_t newCapacity)
+    {
+        if constexpr (is_trivially_relocatable_v<T> && AllocatorTraits<Allocator>::can_reallocate)
+        {
+            if(data_)
+            {
+                T* newData = allocator_.reallocate(data_, capacity_, newCapacity);
+                if(!newData) throw Error::OutOfMemory;
+
+                // Wrapped run [0, tail) moves behind the first one, or first run moves to the end of buffer.
+                size_t first = std::min(size_, capacity_ - head_), tail = size_ - first;
+                if(tail <= first)
+                {
+                    std::memcpy(static_cast<void*>(newData + capacity_), newData, tail * sizeof(T));
+                }
+                else
+                {
+                    size_t newHead = newCapacity - first;
+                    std::memmove(static_cast<void*>(newData + newHead), newData + head_, first * sizeof(T));
+                    head_ = newHead;
+                }
+                data_     = newData;
+                capacity_ = newCapacity;
+                return;
+            }
+        }
+
+        T* newData = allocator_.allocate(newCapacity);
+        if(!newData) throw Error::OutOfMemory;
+
+        try
+        {
+            relocateTo_(newData);
+        }
+        catch(...)
+        {
+            allocator_.deallocate(newData, newCapacity);
+            throw;
+        }
+        if(data_) allocator_.deallocate(data_, capacity_);
+        data_     = newData;
+        capacity_ = newCapacity;
+        head_     = 0;
+    }
+};
+
+}
+
+#endif /* MGKTL_MDATA_RINGBUFFER_HPP */
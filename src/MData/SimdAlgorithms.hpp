@@ -0,0 +1,265 @@
+#ifndef MGKTL_MDATA_SIMDALGORITHMS_HPP
+#define MGKTL_MDATA_SIMDALGORITHMS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+// Kernels compare floats exactly on purpose, and pass vectors only between functions of one instruction set.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+namespace mgk::simd {
+
+/**
+ * @brief Instruction sets kernels are compiled for. Best one supported by CPU is picked at run time.
+ */
+enum class Isa
+{
+    Scalar,
+    Avx2,
+    Avx512,
+};
+
+namespace detail {
+
+    inline Isa detectIsa()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+           __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl"))
+            return Isa::Avx512;
+        if(__builtin_cpu_supports("avx2"))
+            return Isa::Avx2;
+#endif
+        return Isa::Scalar;
+    }
+
+    /// Best instruction set of CPU, detected once at start up.
+    inline const Isa bestIsa = detectIsa();
+
+    /// Instruction set used by dispatch. Relaxed loads suffice: any value picks a working kernel.
+    inline std::atomic<Isa> isa{bestIsa};
+
+    template<size_t BYTES>
+    using SignedOfSize = std::conditional_t<BYTES == 1, int8_t,  std::conditional_t<BYTES == 2, int16_t,
+                         std::conditional_t<BYTES == 4, int32_t, int64_t>>>;
+
+    /// Integers are summed in 64 bits, floating point values in their own type.
+    template<class T>
+    using SumType = std::conditional_t<std::is_floating_point_v<T>, T,
+                    std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>>;
+
+    /// Plain loops. Used on CPUs without AVX2 and on other architectures.
+    template<class T>
+    struct ScalarKernels
+    {
+        using Acc = SumType<T>;
+
+        static size_t find(const T* data, size_t n, T value)
+        {
+            for(size_t i = 0; i < n; ++i)
+            {
+                if(data[i] == value) return i;
+            }
+            return n;
+        }
+
+        static size_t count(const T* data, size_t n, T value)
+        {
+            size_t total = 0;
+            for(size_t i = 0; i < n; ++i) total += data[i] == value;
+            return total;
+        }
+
+        static std::pair<T, T> minmax(const T* data, size_t n)
+        {
+            T lo = data[0], hi = data[0];
+            for(size_t i = 1; i < n; ++i)
+            {
+                lo = data[i] < lo ? data[i] : lo;
+                hi = data[i] > hi ? data[i] : hi;
+            }
+            return {lo, hi};
+        }
+
+        static T min(const T* data, size_t n)
+        {
+            T lo = data[0];
+            for(size_t i = 1; i < n; ++i) lo = data[i] < lo ? data[i] : lo;
+            return lo;
+        }
+
+        static T max(const T* data, size_t n)
+        {
+            T hi = data[0];
+            for(size_t i = 1; i < n; ++i) hi = data[i] > hi ? data[i] : hi;
+            return hi;
+        }
+
+        static Acc sum(const T* data, size_t n)
+        {
+            Acc total = 0;
+            for(size_t i = 0; i < n; ++i) total += static_cast<Acc>(data[i]);
+            return total;
+        }
+
+        static Acc dot(const T* a, const T* b, size_t n)
+        {
+            Acc total = 0;
+            for(size_t i = 0; i < n; ++i) total += static_cast<Acc>(a[i]) * static_cast<Acc>(b[i]);
+            return total;
+        }
+    };
+
+#if defined(__x86_64__) || defined(__i386__)
+    // Target is set for whole region rather than per function: GCC splits vector operations of functions compiled
+    // without AVX before they get inlined anywhere.
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+    namespace avx2 {
+        constexpr size_t WIDTH = 32;
+#include "SimdKernels.hpp"
+    }
+#if defined(__clang__)
+#pragma clang attribute pop
+#pragma clang attribute push(__attribute__((target("avx512f,avx512bw,avx512dq,avx512vl"))), apply_to = function)
+#else
+#pragma GCC pop_options
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw,avx512dq,avx512vl")
+#endif
+    namespace avx512 {
+        constexpr size_t WIDTH = 64;
+#include "SimdKernels.hpp"
+    }
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#define MGK_SIMD_DISPATCH(T, call)                                  \
+    switch(detail::isa.load(std::memory_order_relaxed))             \
+    {                                                               \
+        case Isa::Avx512: return detail::avx512::Kernels<T>::call;  \
+        case Isa::Avx2:   return detail::avx2::Kernels<T>::call;    \
+        case Isa::Scalar:                                           \
+        default:          return detail::ScalarKernels<T>::call;    \
+    }
+#else
+#define MGK_SIMD_DISPATCH(T, call) return detail::ScalarKernels<T>::call;
+#endif
+
+    template<class C>
+    using ElementOf = std::remove_cvref_t<decltype(*std::declval<const C&>().data())>;
+}
+
+/**
+ * @brief Contiguous container of integers or floating point values: Vector, SmallVector, VirtualVector and alike.
+ */
+template<class C>
+concept ArithmeticContainer = requires(const C& c)
+{
+    {c.data()} -> std::convertible_to<const detail::ElementOf<C>*>;
+    {c.size()} -> std::convertible_to<size_t>;
+} && std::is_arithmetic_v<detail::ElementOf<C>> && !std::is_same_v<detail::ElementOf<C>, bool>;
+
+inline Isa activeIsa() { return detail::isa.load(std::memory_order_relaxed); }
+
+/**
+ * @brief Limits kernels to given instruction set, e.g. for testing. Instruction sets unsupported by CPU are ignored.
+ * Other threads may dispatch meanwhile. Called rarely, so kept out of line.
+ * @return instruction set which is used now.
+ */
+[[gnu::noinline]] inline Isa setIsa(Isa isa)
+{
+    isa = std::min(isa, detail::bestIsa);
+    detail::isa.store(isa, std::memory_order_relaxed);
+    return isa;
+}
+
+/// Index of first element equal to value, size() if there is none.
+template<ArithmeticContainer C>
+size_t find(const C& c, detail::ElementOf<C> value)
+{
+    using T = detail::ElementOf<C>;
+    using namespace detail;
+    MGK_SIMD_DISPATCH(T, find(c.data(), c.size(), value))
+}
+
+template<ArithmeticContainer C>
+size_t count(const C& c, detail::ElementOf<C> value)
+{
+    using T = detail::ElementOf<C>;
+    using namespace detail;
+    MGK_SIMD_DISPATCH(T, count(c.data(), c.size(), value))
+}
+
+/// Smallest and largest elements, nothing for empty container. NaNs are skipped unless first element is NaN.
+template<ArithmeticContainer C>
+std::optional<std::pair<detail::ElementOf<C>, detail::ElementOf<C>>> minmax(const C& c)
+{
+    using T = detail::ElementOf<C>;
+    using namespace detail;
+    if(c.size() == 0) return std::nullopt;
+    MGK_SIMD_DISPATCH(T, minmax(c.data(), c.size()))
+}
+
+/// Smallest element, NaNs are treated as by minmax().
+template<ArithmeticContainer C>
+std::optional<detail::ElementOf<C>> min(const C& c)
+{
+    using T = detail::ElementOf<C>;
+    using namespace detail;
+    if(c.size() == 0) return std::nullopt;
+    MGK_SIMD_DISPATCH(T, min(c.data(), c.size()))
+}
+
+/// Largest element, NaNs are treated as by minmax().
+template<ArithmeticContainer C>
+std::optional<detail::ElementOf<C>> max(const C& c)
+{
+    using T = detail::ElementOf<C>;
+    using namespace detail;
+    if(c.size() == 0) return std::nullopt;
+    MGK_SIMD_DISPATCH(T, max(c.data(), c.size()))
+}
+
+/// Sum of elements. Integers are summed in 64 bits. Order of floating point additions depends on instruction set.
+template<ArithmeticContainer C>
+detail::SumType<detail::ElementOf<C>> sum(const C& c)
+{
+    using T = detail::ElementOf<C>;
+    using namespace detail;
+    MGK_SIMD_DISPATCH(T, sum(c.data(), c.size()))
+}
+
+/// Dot product over common prefix of a and b.
+template<ArithmeticContainer C>
+detail::SumType<detail::ElementOf<C>> dot(const C& a, const C& b)
+{
+    using T = detail::ElementOf<C>;
+    using namespace detail;
+    size_t n = std::min<size_t>(a.size(), b.size());
+    MGK_SIMD_DISPATCH(T, dot(a.data(), b.data(), n))
+}
+
+#undef MGK_SIMD_DISPATCH
+
+}
+
+#pragma GCC diagnostic pop
+
+#endif /* MGKTL_MDATA_SIMDALGORITHMS_HPP */
@@ -0,0 +1,205 @@
+// Kernels for one vector width. Included by SimdAlgorithms.hpp once per instruction set, inside namespace which
+// defines WIDTH in bytes and under matching target pragma, so there is no include guard.
+
+/**
+ * @brief Kernels over WIDTH byte vectors, compiled for instruction set of including namespace.
+ */
+template<class T>
+struct Kernels
+{
+    using Acc = SumType<T>;
+
+    typedef T   V  __attribute__((vector_size(WIDTH)));
+    typedef Acc VA __attribute__((vector_size(WIDTH)));
+
+    static constexpr size_t LANES     = WIDTH / sizeof(T);
+    static constexpr size_t ACC_LANES = WIDTH / sizeof(Acc);
+
+    /// ACC_LANES values of T, widened to Acc on load.
+    typedef T VN __attribute__((vector_size(sizeof(T) * ACC_LANES)));
+
+    /// Comparisons give lanes of -1 and 0 of same width as T.
+    using MaskLane = SignedOfSize<sizeof(T)>;
+    typedef MaskLane Mask     __attribute__((vector_size(WIDTH)));
+
+    static V load(const T* ptr)
+    {
+        V v;
+        __builtin_memcpy(&v, ptr, sizeof(V));
+        return v;
+    }
+
+    static VA loadWide(const T* ptr)
+    {
+        VN v;
+        __builtin_memcpy(&v, ptr, sizeof(VN));
+        return __builtin_convertvector(v, VA);
+    }
+
+    static V broadcast(T value)
+    {
+        V v;
+        for(size_t i = 0; i < LANES; ++i) v[i] = value;
+        return v;
+    }
+
+    static bool any(Mask mask)
+    {
+        // Halves are folded together, extracting every lane is slow for wide vectors.
+        typedef uint64_t Half __attribute__((vector_size(16)));
+        Half acc{}, half;
+        for(size_t offset = 0; offset < WIDTH; offset += sizeof(Half))
+        {
+            __builtin_memcpy(&half, reinterpret_cast<const char*>(&mask) + offset, sizeof(Half));
+            acc |= half;
+        }
+        return (acc[0] | acc[1]) != 0;
+    }
+
+    template<class Vec>
+    static auto reduceSum(Vec v)
+    {
+        std::remove_cvref_t<decltype(v[0])> acc = 0;
+        for(size_t i = 0; i < sizeof(Vec) / sizeof(acc); ++i) acc += v[i];
+        return acc;
+    }
+
+    static size_t find(const T* data, size_t n, T value)
+    {
+        const V key = broadcast(value);
+        size_t i = 0;
+        for(; i + 4 * LANES <= n; i += 4 * LANES)
+        {
+            Mask m = (load(data + i) == key) | (load(data + i + LANES) == key) |
+                     (load(data + i + 2 * LANES) == key) | (load(data + i + 3 * LANES) == key);
+            if(any(m)) break;
+        }
+        for(; i < n; ++i)
+        {
+            if(data[i] == value) return i;
+        }
+        return n;
+    }
+
+    static size_t count(const T* data, size_t n, T value)
+    {
+        // Lanes count down by one per match, so narrow lanes are flushed before they overflow.
+        constexpr size_t FLUSH = sizeof(MaskLane) >= 4 ? SIZE_MAX : (size_t(1) << (8 * sizeof(MaskLane) - 1)) - 1;
+
+        const V key = broadcast(value);
+        size_t total = 0;
+        size_t i = 0;
+        while(i + LANES <= n)
+        {
+            Mask acc{};
+            for(size_t step = 0; step < FLUSH && i + LANES <= n; ++step, i += LANES)
+            {
+                acc += (load(data + i) == key);
+            }
+            for(size_t lane = 0; lane < LANES; ++lane) total += static_cast<size_t>(-static_cast<int64_t>(acc[lane]));
+        }
+        for(; i < n; ++i)
+        {
+            total += data[i] == value;
+        }
+        return total;
+    }
+
+    /// Requires n > 0.
+    static std::pair<T, T> minmax(const T* data, size_t n)
+    {
+        T lo = data[0], hi = data[0];
+        size_t i = 0;
+        if(n >= LANES)
+        {
+            // Lanes start from first element, not first vector: NaN in first vector would stick to its lane.
+            V vlo = broadcast(data[0]), vhi = vlo;
+            for(; i + LANES <= n; i += LANES)
+            {
+                V v = load(data + i);
+                vlo = v < vlo ? v : vlo;
+                vhi = v > vhi ? v : vhi;
+            }
+            for(size_t lane = 0; lane < LANES; ++lane)
+            {
+                lo = vlo[lane] < lo ? vlo[lane] : lo;
+                hi = vhi[lane] > hi ? vhi[lane] : hi;
+            }
+        }
+        for(; i < n; ++i)
+        {
+            lo = data[i] < lo ? data[i] : lo;
+            hi = data[i] > hi ? data[i] : hi;
+        }
+        return {lo, hi};
+    }
+
+    /// Requires n > 0.
+    static T min(const T* data, size_t n) { return extreme_<false>(data, n); }
+
+    /// Requires n > 0.
+    static T max(const T* data, size_t n) { return extreme_<true>(data, n); }
+
+    /// Smallest or, when MAX, largest element. NaNs are skipped the same way as by minmax.
+    template<bool MAX>
+    static T extreme_(const T* data, size_t n)
+    {
+        T best = data[0];
+        size_t i = 0;
+        if(n >= LANES)
+        {
+            V vbest = broadcast(data[0]);
+            for(; i + LANES <= n; i += LANES)
+            {
+                V v = load(data + i);
+                if constexpr (MAX) vbest = v > vbest ? v : vbest;
+                else               vbest = v < vbest ? v : vbest;
+            }
+            for(size_t lane = 0; lane < LANES; ++lane)
+            {
+                best = (MAX ? vbest[lane] > best : vbest[lane] < best) ? vbest[lane] : best;
+            }
+        }
+        for(; i < n; ++i)
+        {
+            best = (MAX ? data[i] > best : data[i] < best) ? data[i] : best;
+        }
+        return best;
+    }
+
+    static Acc sum(const T* data, size_t n)
+    {
+        VA acc0{}, acc1{}, acc2{}, acc3{};
+        size_t i = 0;
+        for(; i + 4 * ACC_LANES <= n; i += 4 * ACC_LANES)
+        {
+            acc0 += loadWide(data + i);
+            acc1 += loadWide(data + i + ACC_LANES);
+            acc2 += loadWide(data + i + 2 * ACC_LANES);
+            acc3 += loadWide(data + i + 3 * ACC_LANES);
+        }
+        Acc total = reduceSum((acc0 + acc1) + (acc2 + acc3));
+        for(; i < n; ++i)
+        {
+            total += static_cast<Acc>(data[i]);
+        }
+        return total;
+    }
+
+    static Acc dot(const T* a, const T* b, size_t n)
+    {
+        VA acc0{}, acc1{};
+        size_t i = 0;
+        for(; i + 2 * ACC_LANES <= n; i += 2 * ACC_LANES)
+        {
+            acc0 += loadWide(a + i) * loadWide(b + i);
+            acc1 += loadWide(a + i + ACC_LANES) * loadWide(b + i + ACC_LANES);
+        }
+        Acc total = reduceSum(acc0 + acc1);
+        for(; i < n; ++i)
+        {
+            total += static_cast<Acc>(a[i]) * static_cast<Acc>(b[i]);
+        }
+        return total;
+    }
+};
@@ -0,0 +1,231 @@
+#ifndef MGKTL_MDATA_SLABALLOCATOR_HPP
+#define MGKTL_MDATA_SLABALLOCATOR_HPP
+
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <sys/mman.h>
+
+#include "Allocator.hpp"
+
+namespace mgk {
+
+const size_t SLAB_MAX_SIZE = 4096;
+const size_t OS_PAGE_SZ    = 4096;
+
+/**
+ * @brief General purpose heap of size classes from 8 B to SLAB_MAX_SIZE.
+ *
+ * Every size class carves its own ALLOC_PAGE_SZ pages into intrusive free list, same way as BucketAllocator does.
+ * Bigger requests go directly to mmap. Heap is not thread-safe, use one heap per thread. Only shared heap
+ * returned by instance(), which is default one of SlabAllocator, takes lock on every call.
+ */
+class SlabHeap
+{
+public:
+    /// 8..128 with step 8, then four classes per power of two up to SLAB_MAX_SIZE.
+    static constexpr size_t N_CLASSES = 16 + 4 * 5;
+
+    static constexpr size_t classSize(size_t cls)
+    {
+        if(cls < 16) return 8 * (cls + 1);
+        size_t base = 128ul << ((cls - 16) / 4);
+        return base + base / 4 * ((cls - 16) % 4 + 1);
+    }
+
+    static constexpr size_t sizeClass(size_t bytes)
+    {
+        assert(bytes <= SLAB_MAX_SIZE);
+        if(bytes <= 128) return bytes ? (bytes - 1) / 8 : 0;
+
+        size_t order   = std::bit_width(bytes - 1) - 1;
+        size_t quarter = (1ul << order) / 4;
+        return 16 + 4 * (order - 7) + (bytes - (1ul << order) - 1) / quarter;
+    }
+
+    /// Bytes really available in block for request of given size.
+    static constexpr size_t goodSize(size_t bytes)
+    {
+        if(bytes > SLAB_MAX_SIZE) return (bytes + OS_PAGE_SZ - 1) / OS_PAGE_SZ * OS_PAGE_SZ;
+        return classSize(sizeClass(bytes));
+    }
+
+    static SlabHeap& instance()
+    {
+        static SlabHeap heap(true);
+        return heap;
+    }
+
+    SlabHeap() : lock_(), classes_() {}
+
+    SlabHeap(const SlabHeap&)            = delete;
+    SlabHeap& operator=(const SlabHeap&) = delete;
+
+    ~SlabHeap()
+    {
+        for(auto& pool : classes_)
+        {
+            while(pool.pages)
+            {
+                PageHeader* page = pool.pages;
+                pool.pages = page->next;
+                ::operator delete[](reinterpret_cast<char* >(page), std::align_val_t(4096));
+            }
+            pool.free = nullptr;
+        }
+    }
+
+    [[nodiscard]]
+    void* allocate(size_t bytes)
+    {
+        if(bytes > SLAB_MAX_SIZE)
+        {
+            void* mem = mmap(nullptr, roundToOsPage(bytes), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(mem == MAP_FAILED) throw std::bad_alloc();
+            return mem;
+        }
+
+        std::unique_lock<std::mutex> guard = lock();
+        size_t cls = sizeClass(bytes);
+        SizeClass& pool = classes_[cls];
+        if(pool.free == nullptr)
+        {
+            createPage(pool, classSize(cls));
+        }
+
+        SLList* node = pool.free;
+        pool.free = node->next;
+        return node;
+    }
+
+    void deallocate(void* ptr, size_t bytes)
+    {
+        if(!ptr) return;
+
+        if(bytes > SLAB_MAX_SIZE)
+        {
+            munmap(ptr, roundToOsPage(bytes));
+            return;
+        }
+
+        std::unique_lock<std::mutex> guard = lock();
+        SizeClass& pool = classes_[sizeClass(bytes)];
+        SLList* node = static_cast<SLList* >(ptr);
+        node->next = pool.free;
+        pool.free = node;
+    }
+
+private:
+    struct SLList
+    {
+        SLList* next;
+    };
+
+    /// Lives at start of every page. Padded to 16 bytes to keep nodes 16-aligned.
+    struct alignas(16) PageHeader
+    {
+        PageHeader* next;
+    };
+
+    struct SizeClass
+    {
+        SLList*     free  = nullptr;
+        PageHeader* pages = nullptr;
+    };
+
+    std::mutex lock_;
+    SizeClass  classes_[N_CLASSES];
+    bool       shared_ = false;
+
+    explicit SlabHeap(bool shared) : lock_(), classes_(), shared_(shared) {}
+
+    /// Lock held for call on shared heap, empty one otherwise.
+    std::unique_lock<std::mutex> lock()
+    {
+        return shared_ ? std::unique_lock<std::mutex>(lock_) : std::unique_lock<std::mutex>();
+    }
+
+    static constexpr size_t roundToOsPage(size_t bytes)
+    {
+        return (bytes + OS_PAGE_SZ - 1) / OS_PAGE_SZ * OS_PAGE_SZ;
+    }
+
+    static void createPage(SizeClass& pool, size_t nodeSize)
+    {
+        char* page = new(std::align_val_t(4096)) char[ALLOC_PAGE_SZ];
+
+        PageHeader* header = reinterpret_cast<PageHeader* >(page);
+        header->next = pool.pages;
+        pool.pages   = header;
+
+        size_t nNodes = (ALLOC_PAGE_SZ - sizeof(PageHeader)) / nodeSize;
+        char*  nodes  = page + sizeof(PageHeader);
+        // Push from the end so that free list goes in address order.
+        for(size_t i = nNodes; i != 0; --i)
+        {
+            SLList* node = reinterpret_cast<SLList* >(nodes + (i - 1) * nodeSize);
+            node->next = pool.free;
+            pool.free  = node;
+        }
+    }
+};
+
+static_assert(SlabHeap::classSize(SlabHeap::N_CLASSES - 1) == SLAB_MAX_SIZE);
+static_assert(SlabHeap::sizeClass(SLAB_MAX_SIZE) == SlabHeap::N_CLASSES - 1);
+
+/**
+ * @brief Allocator handle over SlabHeap. Satisfies mgk::Allocator, so can be used by Vector.
+ *
+ * @tparam T - type of allocated elements. Alignment must be at most 16.
+ */
+template<class T>
+class SlabAllocator
+{
+    static_assert(alignof(T) <= 16, "SlabHeap guarantees only 16 byte alignment");
+
+public:
+    using value_type = T;
+
+    SlabAllocator() = default;
+    SlabAllocator(SlabHeap& heap) : heap_(&heap) {}
+
+    template<class U>
+    SlabAllocator(const SlabAllocator<U>& oth) : heap_(oth.heap()) {}
+
+    [[nodiscard]]
+    T* allocate(size_t size = 1)
+    {
+        return static_cast<T* >(heap_->allocate(bytes(size)));
+    }
+
+    void deallocate(T* ptr, size_t size = 1)
+    {
+        heap_->deallocate(ptr, bytes(size));
+    }
+
+    /// Elements which fit into block allocated for size elements.
+    size_t good_size(size_t size) const
+    {
+        return SlabHeap::goodSize(bytes(size)) / sizeof(T);
+    }
+
+    SlabHeap* heap() const { return heap_; }
+
+    bool operator==(const SlabAllocator& oth) const { return heap_ == oth.heap_; }
+
+private:
+    SlabHeap* heap_ = &SlabHeap::instance();
+
+    static size_t bytes(size_t size)
+    {
+        if(size > SIZE_MAX / sizeof(T)) throw std::bad_alloc();
+        return size ? size * sizeof(T) : 1;
+    }
+};
+
+}
+
+#endif /* MGKTL_MDATA_SLABALLOCATOR_HPP */
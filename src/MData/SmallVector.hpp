@@ -0,0 +1,294 @@
+#ifndef MGKTL_MDATA_SMALLVECTOR_HPP
+#define MGKTL_MDATA_SMALLVECTOR_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <MUtils/utils.hpp>
+#include "Allocator.hpp"
+#include "Vector.hpp"
+
+namespace mgk {
+
+/**
+ * @brief Vector which keeps up to N elements inline and spills to allocator when it outgrows them.
+ *
+ * Move of spilled vector steals its buffer, move of inline one relocates elements.
+ */
+template<class T, size_t N, class Allocator = DefaultDynamicAllocator<T>>
+requires std::destructible<T>
+class SmallVector
+{
+public:
+    enum class Error
+    {
+        Ok,
+        OutOfRange,
+        OutOfMemory,
+        BadObject,
+        DifferentContainerIterator,
+    };
+
+    using iterator       = RAIterator<T, SmallVector>;
+    using const_iterator = RAConstIterator<T, SmallVector>;
+
+    SmallVector() : allocator_() {}
+
+    explicit SmallVector(const Allocator& allocator) : allocator_(allocator) {}
+
+    SmallVector(size_t n, const Allocator& allocator = Allocator()) : allocator_(allocator)
+    {
+        resize(n);
+    }
+
+    SmallVector(size_t n, const T& fill, const Allocator& allocator = Allocator()) : allocator_(allocator)
+    {
+        assign(n, fill);
+    }
+
+    SmallVector(const SmallVector& oth) : allocator_(oth.allocator_)
+    {
+        *this = oth;
+    }
+
+    SmallVector& operator=(const SmallVector& oth)
+    {
+        if(this == &oth) return *this;
+
+        clean();
+        reserve(oth.size_);
+        if constexpr (std::is_trivially_copyable<T>::value)
+        {
+            if(oth.size_) std::memcpy(static_cast<void*>(data_), oth.data_, oth.size_ * sizeof(T));
+            size_ = oth.size_;
+            return *this;
+        }
+        for(; size_ < oth.size_; ++size_)
+        {
+            new(&data_[size_]) T(oth.data_[size_]);
+        }
+        return *this;
+    }
+
+    SmallVector(SmallVector&& oth) : allocator_(oth.allocator_)
+    {
+        steal_(oth);
+    }
+
+    SmallVector& operator=(SmallVector&& oth)
+    {
+        if(this == &oth) return *this;
+
+        clean();
+        release_();
+        allocator_ = oth.allocator_;
+        steal_(oth);
+        return *this;
+    }
+
+    ~SmallVector()
+    {
+        clean();
+        release_();
+    }
+
+    void swap(SmallVector& other)
+    {
+        SmallVector tmp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    size_t size()     const { return size_; }
+    size_t capacity() const { return capacity_; }
+    bool   empty()    const { return size_ == 0; }
+
+    /// Elements are stored inline, no allocation is owned.
+    bool isInline() const { return data_ == inlineData_(); }
+
+    T*       data()       { return data_; }
+    const T* data() const { return data_; }
+
+    const Allocator& get_allocator() const { return allocator_; }
+
+    bool validate() const noexcept(true)
+    {
+        return data_ != nullptr && capacity_ >= size_ && capacity_ >= N;
+    }
+
+    void validateThrow() const noexcept(false)
+    {
+        if(!validate()) throw Error::BadObject;
+    }
+
+    void reserve(size_t newCapacity)
+    {
+        if(capacity_ >= newCapacity) return;
+
+        T* newData = allocator_.allocate(newCapacity);
+        if(!newData)
+        {
+            throw Error::OutOfMemory;
+        }
+
+        try
+        {
+            detail::relocate(newData, data_, size_);
+        }
+        catch(...)
+        {
+            allocator_.deallocate(newData, newCapacity);
+            throw;
+        }
+        release_();
+        data_     = newData;
+        capacity_ = newCapacity;
+    }
+
+    void resize(size_t newSize, const T& fill)
+    {
+        shrink_(newSize);
+        reserve(newSize);
+        for(; size_ < newSize; ++size_)
+        {
+            new(&data_[size_]) T(fill);
+        }
+    }
+
+    void resize(size_t newSize)
+    {
+        shrink_(newSize);
+        reserve(newSize);
+        if constexpr (std::is_trivially_default_constructible<T>::value)
+        {
+            size_ = std::max(size_, newSize);
+            return;
+        }
+        for(; size_ < newSize; ++size_)
+        {
+            new(&data_[size_]) T;
+        }
+    }
+
+    void assign(size_t n, const T& fill)
+    {
+        clean();
+        resize(n, fill);
+    }
+
+    void clean() { shrink_(0); }
+
+    const T& operator[](size_t i) const
+    {
+        if(i >= size_)
+        {
+            throw Error::OutOfRange;
+        }
+        return data_[i];
+    }
+
+    T& operator[](size_t i)
+    {
+        if(i >= size_)
+        {
+            throw Error::OutOfRange;
+        }
+        return data_[i];
+    }
+
+    void push_back(const T& t)
+    {
+        if(size_ == capacity_)
+        {
+            // t may live in this vector, so it is copied before old buffer is released.
+            T copy(t);
+            reserve(2 * capacity_);
+            new (&data_[size_]) T(std::move(copy));
+        }
+        else
+        {
+            new (&data_[size_]) T(t);
+        }
+        size_++;
+    }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, size_); }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size_); }
+
+    std::reverse_iterator<iterator> rbegin() { return std::reverse_iterator<iterator>(end()); }
+    std::reverse_iterator<iterator> rend() { return std::reverse_iterator<iterator>(begin()); }
+
+    std::reverse_iterator<const_iterator> rbegin() const { return std::reverse_iterator<const_iterator>(end()); }
+    std::reverse_iterator<const_iterator> rend() const   { return std::reverse_iterator<const_iterator>(begin()); }
+
+    bool operator==(const SmallVector&) = delete;
+
+private:
+    static_assert(N > 0, "Use Vector for no inline storage");
+
+    T* data_ = inlineData_();
+
+    size_t size_     = 0;
+    size_t capacity_ = N;
+
+    Allocator allocator_;
+
+    alignas(T) unsigned char inline_[N * sizeof(T)];
+
+    T* inlineData_() const
+    {
+        return reinterpret_cast<T* >(const_cast<unsigned char* >(inline_));
+    }
+
+    /// Takes elements of oth, which is left empty and inline. This vector must be empty and inline.
+    void steal_(SmallVector& oth)
+    {
+        if(oth.isInline())
+        {
+            detail::relocate(data_, oth.data_, oth.size_);
+        }
+        else
+        {
+            data_          = oth.data_;
+            capacity_      = oth.capacity_;
+            oth.data_      = oth.inlineData_();
+            oth.capacity_  = N;
+        }
+        size_     = oth.size_;
+        oth.size_ = 0;
+    }
+
+    /// Frees heap buffer, elements must be destroyed already.
+    void release_()
+    {
+        if(!isInline()) allocator_.deallocate(data_, capacity_);
+        data_     = inlineData_();
+        capacity_ = N;
+    }
+
+    void shrink_(size_t newSize)
+    {
+        if constexpr (!std::is_trivially_destructible<T>::value)
+        {
+            for(size_t i = newSize; i < size_; ++i)
+            {
+                data_[i].~T();
+            }
+        }
+        size_ = std::min(size_, newSize);
+    }
+};
+
+}
+
+#endif /* MGKTL_MDATA_SMALLVECTOR_HPP */
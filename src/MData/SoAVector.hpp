@@ -0,0 +1,402 @@
+#ifndef MGKTL_MDATA_SOAVECTOR_HPP
+#define MGKTL_MDATA_SOAVECTOR_HPP
+
+#include <algorithm>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <MUtils/utils.hpp>
+#include "Allocator.hpp"
+
+namespace mgk {
+
+/**
+ * @brief Structure of arrays: every field lives in its own column, all columns share size and capacity.
+ *
+ * Loops over one or two fields read only their columns, use column<I>() for them. Rows are accessed through
+ * tuples of references, so auto [x, y] = v[i] binds to elements and v[i] = value_type{x, y} writes them.
+ */
+template<template<class> class Allocator, class... Fields>
+requires (sizeof...(Fields) > 0) && (std::destructible<Fields> && ...)
+class BasicSoAVector
+{
+    template<size_t I>
+    using Field = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+    template<bool CONST>
+    class RowIterator;
+
+public:
+    enum class Error
+    {
+        Ok,
+        OutOfRange,
+        OutOfMemory,
+        BadObject,
+        DifferentContainerIterator,
+    };
+
+    using value_type      = std::tuple<Fields...>;
+    using reference       = std::tuple<Fields&...>;
+    using const_reference = std::tuple<const Fields&...>;
+
+    using iterator       = RowIterator<false>;
+    using const_iterator = RowIterator<true>;
+
+    static constexpr size_t FIELD_COUNT = sizeof...(Fields);
+
+    BasicSoAVector() {}
+
+    explicit BasicSoAVector(size_t n)
+    {
+        resize(n);
+    }
+
+    BasicSoAVector(const BasicSoAVector& oth)
+    {
+        *this = oth;
+    }
+
+    BasicSoAVector& operator=(const BasicSoAVector& oth)
+    {
+        if(this == &oth) return *this;
+
+        clean();
+        reserve(oth.size_);
+        for(size_t i = 0; i < oth.size_; ++i)
+        {
+            std::apply([this](const Fields&... fields) { constructRow_(size_, fields...); }, oth[i]);
+            ++size_;
+        }
+        return *this;
+    }
+
+    BasicSoAVector(BasicSoAVector&& oth)
+    {
+        swap(oth);
+    }
+
+    BasicSoAVector& operator=(BasicSoAVector&& oth)
+    {
+        swap(oth);
+        return *this;
+    }
+
+    ~BasicSoAVector()
+    {
+        clean();
+        release_(columns_, capacity_);
+    }
+
+    void swap(BasicSoAVector& other)
+    {
+        std::swap(columns_   , other.columns_);
+        std::swap(size_      , other.size_);
+        std::swap(capacity_  , other.capacity_);
+        std::swap(allocators_, other.allocators_);
+    }
+
+    size_t size()     const { return size_; }
+    size_t capacity() const { return capacity_; }
+    bool   empty()    const { return size_ == 0; }
+
+    bool validate() const noexcept(true)
+    {
+        bool allocated = std::apply([](Fields* const&... column) { return ((column != nullptr) && ...); }, columns_);
+        return capacity_ >= size_ && (allocated || capacity_ == 0);
+    }
+
+    void validateThrow() const noexcept(false)
+    {
+        if(!validate()) throw Error::BadObject;
+    }
+
+    /**
+     * @brief Contiguous elements of field I.
+     */
+    template<size_t I>
+    std::span<Field<I>> column()
+    {
+        return {std::get<I>(columns_), size_};
+    }
+
+    template<size_t I>
+    std::span<const Field<I>> column() const
+    {
+        return {std::get<I>(columns_), size_};
+    }
+
+    reference operator[](size_t i)
+    {
+        checkIndex_(i);
+        return std::apply([i](Fields*... column) { return reference(column[i]...); }, columns_);
+    }
+
+    const_reference operator[](size_t i) const
+    {
+        checkIndex_(i);
+        return std::apply([i](Fields* const&... column) { return const_reference(column[i]...); }, columns_);
+    }
+
+    void reserve(size_t newCapacity)
+    {
+        if(capacity_ >= newCapacity) return;
+
+        std::tuple<Fields*...> newColumns{};
+        try
+        {
+            allocateColumns_(newColumns, newCapacity, std::index_sequence_for<Fields...>());
+        }
+        catch(...)
+        {
+            release_(newColumns, newCapacity);
+            throw Error::OutOfMemory;
+        }
+
+        try
+        {
+            relocateColumnsTo_(newColumns, std::index_sequence_for<Fields...>());
+        }
+        catch(...)
+        {
+            release_(newColumns, newCapacity);
+            throw;
+        }
+        release_(columns_, capacity_);
+        columns_  = newColumns;
+        capacity_ = newCapacity;
+    }
+
+    void resize(size_t newSize)
+    {
+        shrink_(newSize);
+        reserve(newSize);
+        for(; size_ < newSize; ++size_)
+        {
+            constructRow_(size_, Fields()...);
+        }
+    }
+
+    void clean() { shrink_(0); }
+
+    void shrink_to_fit()
+    {
+        if(capacity_ == size_) return;
+
+        BasicSoAVector shrunk;
+        shrunk.reserve(size_);
+        relocateColumnsTo_(shrunk.columns_, std::index_sequence_for<Fields...>());
+        shrunk.size_ = size_;
+        size_ = 0;
+        swap(shrunk);
+    }
+
+    /**
+     * @brief Appends row, one value per field.
+     */
+    template<class... Args>
+    requires (sizeof...(Args) == sizeof...(Fields))
+    void push_back(Args&&... values)
+    {
+        if(size_ == capacity_)
+        {
+            // Values may refer to this container, so they are copied before columns move.
+            value_type row(std::forward<Args>(values)...);
+            reserve(std::max<size_t>(2 * capacity_, 1));
+            std::apply([this](Fields&... fields) { constructRow_(size_, std::move(fields)...); }, row);
+        }
+        else
+        {
+            constructRow_(size_, std::forward<Args>(values)...);
+        }
+        ++size_;
+    }
+
+    void push_back(const value_type& row)
+    {
+        std::apply([this](const Fields&... fields) { push_back(fields...); }, row);
+    }
+
+    void pop_back()
+    {
+        if(size_ == 0) throw Error::OutOfRange;
+        shrink_(size_ - 1);
+    }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end()   { return iterator(this, size_); }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end()   const { return const_iterator(this, size_); }
+
+    bool operator==(const BasicSoAVector&) = delete;
+
+private:
+    std::tuple<Fields*...> columns_{};
+
+    size_t size_     = 0;
+    size_t capacity_ = 0;
+
+    std::tuple<Allocator<Fields>...> allocators_{};
+
+    void checkIndex_(size_t i) const
+    {
+        if(i >= size_) throw Error::OutOfRange;
+    }
+
+    template<size_t... Is>
+    void allocateColumns_(std::tuple<Fields*...>& columns, size_t n, std::index_sequence<Is...>)
+    {
+        ((std::get<Is>(columns) = std::get<Is>(allocators_).allocate(n),
+          std::get<Is>(columns) ? void() : throw std::bad_alloc()), ...);
+    }
+
+    void release_(std::tuple<Fields*...>& columns, size_t n)
+    {
+        releaseColumns_(columns, n, std::index_sequence_for<Fields...>());
+    }
+
+    template<size_t... Is>
+    void releaseColumns_(std::tuple<Fields*...>& columns, size_t n, std::index_sequence<Is...>)
+    {
+        ((std::get<Is>(columns) ? std::get<Is>(allocators_).deallocate(std::get<Is>(columns), n) : void(),
+          std::get<Is>(columns) = nullptr), ...);
+    }
+
+    /// Fields which are relocated without exceptions.
+    static constexpr bool NOTHROW_RELOCATE[] = {(is_trivially_relocatable_v<Fields> || std::is_nothrow_move_constructible_v<Fields>)...};
+
+    /// Moves rows to uninitialized columns, rows left here are destroyed. On exception columns hold nothing and rows stay.
+    template<size_t... Is>
+    void relocateColumnsTo_(std::tuple<Fields*...>& columns, std::index_sequence<Is...>)
+    {
+        if constexpr ((NOTHROW_RELOCATE[Is] && ...))
+        {
+            (detail::relocate(std::get<Is>(columns), std::get<Is>(columns_), size_), ...);
+        }
+        else
+        {
+            // Fields which may throw are copied first and destroyed here only when all of them are built.
+            size_t current = 0;
+            try
+            {
+                ((NOTHROW_RELOCATE[Is] ? void() : (current = Is,
+                  detail::uninitialized_move_if_noexcept(std::get<Is>(columns), std::get<Is>(columns_), size_))), ...);
+            }
+            catch(...)
+            {
+                ((!NOTHROW_RELOCATE[Is] && Is < current ? destroy_(std::get<Is>(columns), size_) : void()), ...);
+                throw;
+            }
+            ((NOTHROW_RELOCATE[Is] ? detail::relocate(std::get<Is>(columns), std::get<Is>(columns_), size_)
+                                   : destroy_(std::get<Is>(columns_), size_)), ...);
+        }
+    }
+
+    template<class T>
+    static void destroy_(T* column, size_t n)
+    {
+        if constexpr (!std::is_trivially_destructible_v<T>)
+        {
+            for(size_t i = 0; i < n; ++i) column[i].~T();
+        }
+    }
+
+    /// Constructs fields of row from I onwards. If one throws, fields constructed before it are destroyed.
+    template<size_t I = 0, class Arg, class... Rest>
+    void constructRow_(size_t row, Arg&& arg, Rest&&... rest)
+    {
+        using T = Field<I>;
+        T* column = std::get<I>(columns_);
+        new(&column[row]) T(std::forward<Arg>(arg));
+        if constexpr (sizeof...(Rest) > 0)
+        {
+            try
+            {
+                constructRow_<I + 1>(row, std::forward<Rest>(rest)...);
+            }
+            catch(...)
+            {
+                column[row].~T();
+                throw;
+            }
+        }
+    }
+
+    void shrink_(size_t newSize)
+    {
+        if constexpr (!(std::is_trivially_destructible_v<Fields> && ...))
+        {
+            std::apply([this, newSize](Fields*... column)
+            {
+                for(size_t i = newSize; i < size_; ++i)
+                {
+                    (column[i].~Fields(), ...);
+                }
+            }, columns_);
+        }
+        size_ = std::min(size_, newSize);
+    }
+};
+
+/**
+ * @brief Random access iterator over rows. Dereferencing gives tuple of references.
+ */
+template<template<class> class Allocator, class... Fields>
+requires (sizeof...(Fields) > 0) && (std::destructible<Fields> && ...)
+template<bool CONST>
+class BasicSoAVector<Allocator, Fields...>::RowIterator
+{
+    using Container = std::conditional_t<CONST, const BasicSoAVector, BasicSoAVector>;
+
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type        = BasicSoAVector::value_type;
+    using difference_type   = std::ptrdiff_t;
+    using reference         = std::conditional_t<CONST, BasicSoAVector::const_reference, BasicSoAVector::reference>;
+
+    RowIterator() = default;
+    RowIterator(Container* container, size_t position) : container_(container), position_(position) {}
+
+    reference operator*() const { return (*container_)[position_]; }
+    reference operator[](difference_type diff) const { return (*container_)[position_ + diff]; }
+
+    RowIterator& operator++() { ++position_; return *this; }
+    RowIterator& operator--() { --position_; return *this; }
+    RowIterator operator++(int) { RowIterator old = *this; ++position_; return old; }
+    RowIterator operator--(int) { RowIterator old = *this; --position_; return old; }
+
+    RowIterator& operator+=(difference_type diff) { position_ += diff; return *this; }
+    RowIterator& operator-=(difference_type diff) { position_ -= diff; return *this; }
+
+    RowIterator operator+(difference_type diff) const { return RowIterator(container_, position_ + diff); }
+    RowIterator operator-(difference_type diff) const { return RowIterator(container_, position_ - diff); }
+    friend RowIterator operator+(difference_type diff, const RowIterator& it) { return it + diff; }
+
+    difference_type operator-(const RowIterator& other) const
+    {
+        if(container_ != other.container_) throw Error::DifferentContainerIterator;
+        return static_cast<difference_type>(position_) - static_cast<difference_type>(other.position_);
+    }
+
+    bool operator==(const RowIterator& other) const { return position_ == other.position_; }
+    auto operator<=>(const RowIterator& other) const { return position_ <=> other.position_; }
+
+private:
+    Container* container_ = nullptr;
+    size_t     position_  = 0;
+};
+
+template<class... Fields>
+using SoAVector = BasicSoAVector<DefaultDynamicAllocator, Fields...>;
+
+}
+
+#endif /* MGKTL_MDATA_SOAVECTOR_HPP */
@@ -0,0 +1,259 @@
+#ifndef MGKTL_MDATA_THREADCACHINGALLOCATOR_HPP
+#define MGKTL_MDATA_THREADCACHINGALLOCATOR_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <utility>
+
+#include "Allocator.hpp"
+
+namespace mgk {
+
+/**
+ * @brief Central pool of magazines shared by all threads.
+ *
+ * Magazine is a fixed-size stack of free nodes. Threads trade whole magazines with depot,
+ * so lock is taken once per MAGAZINE_SZ allocations or deallocations. Depot keeps at most MAX_FULL full
+ * magazines, rounds of further ones go back to pool, so memory freed in bursts is not pinned by depot.
+ *
+ * @tparam T           - type of allocated node.
+ * @tparam MAGAZINE_SZ - number of nodes in one magazine.
+ */
+template<class T, size_t MAGAZINE_SZ>
+class MagazineDepot
+{
+public:
+    struct Magazine
+    {
+        Magazine* next = nullptr;
+        size_t    size = 0;
+        T*        rounds[MAGAZINE_SZ];
+
+        bool empty() const { return size == 0; }
+        bool full()  const { return size == MAGAZINE_SZ; }
+    };
+
+    static constexpr size_t MAX_FULL = 16;
+
+    static MagazineDepot& instance()
+    {
+        static MagazineDepot depot;
+        return depot;
+    }
+
+    MagazineDepot(const MagazineDepot&)            = delete;
+    MagazineDepot& operator=(const MagazineDepot&) = delete;
+
+    /**
+     * @brief Takes empty magazine and gives full one. Fills new magazine from pool if depot has no full ones.
+     */
+    [[nodiscard]]
+    Magazine* exchangeEmpty(Magazine* empty)
+    {
+        assert(empty && empty->empty());
+        std::lock_guard<std::mutex> guard(lock_);
+
+        if(full_)
+        {
+            push(empty_, empty);
+            --fullCount_;
+            return pop(full_);
+        }
+
+        for(; empty->size < MAGAZINE_SZ; ++empty->size)
+        {
+            empty->rounds[empty->size] = reinterpret_cast<T* >(nodes_.allocate());
+        }
+        return empty;
+    }
+
+    /**
+     * @brief Takes full magazine and gives empty one, which is same magazine drained if depot is full.
+     */
+    [[nodiscard]]
+    Magazine* exchangeFull(Magazine* full)
+    {
+        assert(full && full->full());
+        std::lock_guard<std::mutex> guard(lock_);
+
+        if(storeFull(full)) return empty_ ? pop(empty_) : createMagazine();
+        return full;
+    }
+
+    [[nodiscard]]
+    Magazine* getEmpty()
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        return empty_ ? pop(empty_) : createMagazine();
+    }
+
+    /**
+     * @brief Returns magazine owned by exiting thread. Rounds of partial magazine go back to pool.
+     */
+    void release(Magazine* mag)
+    {
+        if(!mag) return;
+        std::lock_guard<std::mutex> guard(lock_);
+
+        if(mag->full() && storeFull(mag)) return;
+
+        drain(mag);
+        push(empty_, mag);
+    }
+
+    size_t fullCount()
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        return fullCount_;
+    }
+
+private:
+    MagazineDepot() : lock_(), nodes_(), magazines_() {}
+
+    /// Raw storage of T. Depot never constructs T, so pool must not care about T's destructor.
+    struct Slot
+    {
+        alignas(T) char data[sizeof(T)];
+    };
+
+    std::mutex lock_;
+    BucketAllocator<Slot>     nodes_;
+    BucketAllocator<Magazine> magazines_;
+
+    Magazine* full_  = nullptr;
+    Magazine* empty_ = nullptr;
+
+    size_t fullCount_ = 0;
+
+    static void push(Magazine*& list, Magazine* mag)
+    {
+        mag->next = list;
+        list = mag;
+    }
+
+    static Magazine* pop(Magazine*& list)
+    {
+        Magazine* mag = list;
+        list = mag->next;
+        mag->next = nullptr;
+        return mag;
+    }
+
+    /// Keeps full magazine unless depot has MAX_FULL of them already, in which case it is drained. Lock must be held.
+    bool storeFull(Magazine* mag)
+    {
+        if(fullCount_ == MAX_FULL)
+        {
+            drain(mag);
+            return false;
+        }
+        push(full_, mag);
+        ++fullCount_;
+        return true;
+    }
+
+    void drain(Magazine* mag)
+    {
+        for(; mag->size != 0; --mag->size)
+        {
+            nodes_.deallocate(reinterpret_cast<Slot* >(mag->rounds[mag->size - 1]));
+        }
+    }
+
+    Magazine* createMagazine()
+    {
+        return new(magazines_.allocate()) Magazine;
+    }
+};
+
+/**
+ * @brief Thread-caching front end over shared BucketAllocator pool.
+ *
+ * Every thread keeps two magazines (loaded and previous) and touches depot only when both are
+ * empty on allocation or both are full on deallocation. Node may be freed by any thread, not only
+ * by one which allocated it. All instances with same parameters share one depot.
+ *
+ * @tparam T           - type of allocated node.
+ * @tparam MAGAZINE_SZ - number of nodes moved between thread and depot at once.
+ */
+template<class T, size_t MAGAZINE_SZ = 64>
+requires (MAGAZINE_SZ > 0)
+class ThreadCachingAllocator
+{
+    using Depot    = MagazineDepot<T, MAGAZINE_SZ>;
+    using Magazine = typename Depot::Magazine;
+
+    struct ThreadCache
+    {
+        Depot&    depot    = Depot::instance();
+        Magazine* loaded   = nullptr;
+        Magazine* previous = nullptr;
+
+        ThreadCache() : loaded(depot.getEmpty()), previous(depot.getEmpty()) {}
+
+        ThreadCache(const ThreadCache&)            = delete;
+        ThreadCache& operator=(const ThreadCache&) = delete;
+
+        ~ThreadCache()
+        {
+            depot.release(loaded);
+            depot.release(previous);
+            loaded = previous = nullptr;
+        }
+    };
+
+    static ThreadCache& cache()
+    {
+        thread_local ThreadCache threadCache;
+        return threadCache;
+    }
+
+public:
+    using value_type = T;
+
+    ThreadCachingAllocator() = default;
+
+    [[nodiscard("Do not discard allocated T due to memleak.")]]
+    T* allocate()
+    {
+        ThreadCache& tc = cache();
+        if(tc.loaded->empty())
+        {
+            if(!tc.previous->empty())
+                std::swap(tc.loaded, tc.previous);
+            else
+                tc.loaded = tc.depot.exchangeEmpty(tc.loaded);
+        }
+        return tc.loaded->rounds[--tc.loaded->size];
+    }
+
+    static constexpr size_t max_size() { return 1; }
+
+    void deallocate(T* elem)
+    {
+        if(!elem) return;
+
+        ThreadCache& tc = cache();
+        if(tc.loaded->full())
+        {
+            if(!tc.previous->full())
+            {
+                std::swap(tc.loaded, tc.previous);
+            }
+            else
+            {
+                tc.previous = tc.depot.exchangeFull(tc.previous);
+                std::swap(tc.loaded, tc.previous);
+            }
+        }
+        tc.loaded->rounds[tc.loaded->size++] = elem;
+    }
+
+    bool operator==(const ThreadCachingAllocator&) const { return true; }
+};
+
+}
+
+#endif /* MGKTL_MDATA_THREADCACHINGALLOCATOR_HPP */
@@ -1,21 +1,122 @@
 #ifndef VECTOR_HPP
 #define VECTOR_HPP
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
+#include <functional>
 #include <iterator>
+#include <memory>
+#include <ranges>
 #include <utility>
 #include <cassert>
 #include <concepts>
 #include <new>
+#include <type_traits>
+#include <MUtils/utils.hpp>
 #include "Allocator.hpp"
+#include "AllocatorConcepts.hpp"
 
 namespace mgk {
 
-template<class T, class Allocator = DefaultDynamicAllocator<T>>
+/**
+ * @brief Access policy of Vector: index checks and iterators which know their container.
+ */
+struct CheckedAccess
+{
+    static constexpr bool CHECKED = true;
+};
+
+/**
+ * @brief Access policy of Vector: raw pointer iterators, index checks only by assert.
+ */
+struct UncheckedAccess
+{
+    static constexpr bool CHECKED = false;
+};
+
+/// Same in every build, so type of Vector<T> and behavior of out of range access do not depend on NDEBUG.
+using DefaultAccess = CheckedAccess;
+
+/**
+ * @brief Growth policy of Vector: capacity doubles.
+ */
+struct DoublingGrowth
+{
+    template<class T, class Allocator>
+    static size_t grow(const Allocator&, size_t capacity, size_t required)
+    {
+        return std::max(required, 2 * capacity + 1);
+    }
+};
+
+/**
+ * @brief Growth policy of Vector: capacity grows 1.5 times, so freed blocks may be reused by later growth.
+ */
+struct HalfGrowth
+{
+    template<class T, class Allocator>
+    static size_t grow(const Allocator&, size_t capacity, size_t required)
+    {
+        return std::max(required, capacity + capacity / 2 + 1);
+    }
+};
+
+/**
+ * @brief Growth policy of Vector: capacity doubles and is rounded up to block size which allocator really gives,
+ * see AllocatorTraits::has_good_size. Without it buffers of page size and more are rounded to pages.
+ */
+struct SizeClassGrowth
+{
+    static constexpr size_t PAGE_SZ = 4096;
+
+    template<class T, class Allocator>
+    static size_t grow(const Allocator& allocator, size_t capacity, size_t required)
+    {
+        size_t wanted = DoublingGrowth::grow<T>(allocator, capacity, required);
+        if constexpr (AllocatorTraits<Allocator>::has_good_size)
+        {
+            return allocator.good_size(wanted);
+        }
+        else
+        {
+            if(wanted * sizeof(T) < PAGE_SZ) return wanted;
+            return (wanted * sizeof(T) + PAGE_SZ - 1) / PAGE_SZ * PAGE_SZ / sizeof(T);
+        }
+    }
+};
+
+/**
+ * @brief Growth policy of Vector: capacity doubles until STEP_BYTES, then grows by STEP_BYTES at a time.
+ * Keeps slack of huge buffers bounded.
+ */
+template<size_t STEP_BYTES = 64ul << 20>
+struct StepGrowth
+{
+    template<class T, class Allocator>
+    static size_t grow(const Allocator& allocator, size_t capacity, size_t required)
+    {
+        constexpr size_t STEP = std::max<size_t>(STEP_BYTES / sizeof(T), 1);
+        if(capacity < STEP) return std::min(DoublingGrowth::grow<T>(allocator, capacity, required), std::max(required, STEP));
+        return std::max(required, capacity + STEP);
+    }
+};
+
+/**
+ * @brief Lazy element-wise expression, see VectorExpr.hpp. Writes elements [first, last) of result to out.
+ */
+template<class E, class T>
+concept VectorExpression = requires(const E& expr, T* out, size_t i)
+{
+    {expr.size()} -> std::convertible_to<size_t>;
+    expr.evaluateInto(out, i, i);
+};
+
+template<class T, class Allocator = DefaultDynamicAllocator<T>, class Access = DefaultAccess, class Growth = DoublingGrowth>
 requires std::destructible<T> 
 class Vector;
 
 
-template<class T>
+template<class T, class Container = Vector<T>>
 struct RAConstIterator
     {
 
@@ -79,7 +180,7 @@ struct RAConstIterator
 
         std::strong_ordering operator<=>(const RAConstIterator& other) const
         {
-            if(container_ != other.container_) throw Vector<T>::Error::DifferentContainerIterator;
+            if(container_ != other.container_) throw Container::Error::DifferentContainerIterator;
             return position_ <=> other.position_;
         }
 
@@ -88,7 +189,7 @@ struct RAConstIterator
 
         ptrdiff_t operator-(const RAConstIterator& other) const
         {
-            if(container_ != other.container_) throw Vector<T>::Error::DifferentContainerIterator;
+            if(container_ != other.container_) throw Container::Error::DifferentContainerIterator;
             return position_ - other.position_;
         }
 
@@ -108,26 +209,28 @@ struct RAConstIterator
         }
 
     protected:
-        friend class Vector<T>;
+        friend Container;
 
-        RAConstIterator(const Vector<T>* container, size_t position) : container_(container), position_(position) {}
+        RAConstIterator(const Container* container, size_t position) : container_(container), position_(position) {}
 
         void validateThrow() const
         {
             if(position_ > container_->size()) // Also checks overflow below zero
             {
-                throw Vector<T>::Error::OutOfRange;
+                throw Container::Error::OutOfRange;
             }
         }
 
-        const Vector<T>* container_ = nullptr;
+        const Container* container_ = nullptr;
         size_t position_;
     };
 
-template<class T>
+template<class T, class Container = Vector<T>>
 requires std::destructible<T>
-struct RAIterator : public RAConstIterator<T>
+struct RAIterator : public RAConstIterator<T, Container>
 {
+    using Base = RAConstIterator<T, Container>;
+
     using value_type = T;
     using difference_type = std::ptrdiff_t;
     using pointer = T*;
@@ -138,12 +241,12 @@ struct RAIterator : public RAConstIterator<T>
 
     T& operator*() const
     {
-        return const_cast<T&>(RAConstIterator<T>::operator[]);
+        return const_cast<T&>(Base::operator*());
     }
 
     RAIterator& operator+=(ptrdiff_t diff)
     {
-        RAConstIterator<T>::operator+=(diff);
+        Base::operator+=(diff);
         return *this;
     }
 
@@ -154,27 +257,27 @@ struct RAIterator : public RAConstIterator<T>
 
     RAIterator& operator++()
     {
-        RAConstIterator<T>::operator++();
+        Base::operator++();
         return *this;
     }
 
     RAIterator& operator--()
     {
-        RAConstIterator<T>::operator--();
+        Base::operator--();
         return *this;
     }
 
     RAIterator operator++(int)
     {
         RAIterator copy = *this;
-        RAConstIterator<T>::operator++();
+        Base::operator++();
         return copy;
     }
 
     RAIterator operator--(int)
     {
         RAIterator copy = *this;
-        RAConstIterator<T>::operator--();
+        Base::operator--();
         return copy;
     }  
 
@@ -185,21 +288,28 @@ struct RAIterator : public RAConstIterator<T>
 
     ptrdiff_t operator-(const RAIterator& other) const
     {
-        return RAConstIterator<T>::operator-(other);
+        return Base::operator-(other);
     }
 
     T& operator[](ptrdiff_t diff) const
     {
-        return const_cast<T&>(RAConstIterator<T>::operator[](diff));
+        return const_cast<T&>(Base::operator[](diff));
     }
 
 private:
-    friend class Vector<T>;
+    friend Container;
+
+    RAIterator(const Container* container, size_t position) : Base(container, position) {}
 };
 
 
 
-template<class T, class Allocator>
+/**
+ * @tparam Access - CheckedAccess or UncheckedAccess. Default is CheckedAccess, UncheckedAccess gives contiguous
+ *                  iterators.
+ * @tparam Growth - DoublingGrowth, HalfGrowth, SizeClassGrowth or StepGrowth.
+ */
+template<class T, class Allocator, class Access, class Growth>
 requires std::destructible<T> 
 class Vector
 {
@@ -213,28 +323,54 @@ public:
         DifferentContainerIterator,
     };
 
-    Vector() {}
+    using value_type     = T;
+    using iterator       = std::conditional_t<Access::CHECKED, RAIterator<T, Vector>,      T*>;
+    using const_iterator = std::conditional_t<Access::CHECKED, RAConstIterator<T, Vector>, const T*>;
+
+    Vector() : allocator_() {}
+
+    explicit Vector(const Allocator& allocator) : allocator_(allocator) {}
     
-    Vector(size_t n)
+    Vector(size_t n, const Allocator& allocator = Allocator()) : allocator_(allocator)
     {
         resize(n);
     }
 
-    Vector(size_t n, const T& fill)
+    Vector(size_t n, const T& fill, const Allocator& allocator = Allocator()) : allocator_(allocator)
     {
         assign(n, fill);
     }
     
+    /**
+     * @brief Evaluates expression in one pass, no temporary vectors are created.
+     */
+    template<VectorExpression<T> Expr>
+    Vector(const Expr& expr, const Allocator& allocator = Allocator()) : allocator_(allocator)
+    {
+        *this = expr;
+    }
+
+    template<VectorExpression<T> Expr>
+    Vector& operator=(const Expr& expr)
+    {
+        // This vector may be operand of expression only if sizes match, then its buffer stays in place.
+        if(expr.size() != size_) resize(expr.size());
+        expr.evaluateInto(data_, 0, size_);
+        return *this;
+    }
+
     Vector& operator=(const Vector& oth)
     {
-        reserve(oth.size_);
+        if(this == &oth) return *this;
+
         clean();
+        reserve(oth.size_);
         size_ = oth.size_;
         copyFrom_(oth.data_);
         return *this;
     }
     
-    Vector(const Vector& oth)
+    Vector(const Vector& oth) : allocator_(oth.allocator_)
     {
         *this = oth;
     }
@@ -245,31 +381,36 @@ public:
         return *this;
     }
     
-    Vector(Vector&& oth)
+    Vector(Vector&& oth) : allocator_(oth.allocator_)
     {
-        *this = std::move(oth);
+        swap(oth);
     }
 
     ~Vector() noexcept(true)
     {
         eraseData_(data_, size_);
-        ::operator delete(data_);
+        allocator_.deallocate(data_, capacity_);
         data_ = nullptr;
         capacity_ = size_ = 0;
     }
 
-    void swap(Vector<T>& other)
+    void swap(Vector& other)
     {
         other.validateThrow();
         validateThrow();
 
-        std::swap(data_    , other.data_);
-        std::swap(capacity_, other.capacity_);
-        std::swap(size_    , other.size_);
+        std::swap(data_     , other.data_);
+        std::swap(capacity_ , other.capacity_);
+        std::swap(size_     , other.size_);
+        std::swap(allocator_, other.allocator_);
     }
 
     size_t size() const { return size_; }
 
+    size_t capacity() const { return capacity_; }
+
+    const Allocator& get_allocator() const { return allocator_; }
+
     bool validate() const noexcept(true)
     {
         return 
@@ -284,7 +425,20 @@ public:
 
     void reserve(size_t newCapacity)
     {
-        if(capacity_ > newCapacity) return;
+        if(capacity_ >= newCapacity) return;
+
+        if constexpr (is_trivially_relocatable_v<T> && AllocatorTraits<Allocator>::can_reallocate)
+        {
+            if(data_)
+            {
+                T* newData = allocator_.reallocate(data_, capacity_, newCapacity);
+                if(!newData) throw Error::OutOfMemory;
+
+                data_     = newData;
+                capacity_ = newCapacity;
+                return;
+            }
+        }
         
         T* newData_  = allocator_.allocate(newCapacity);
 
@@ -293,7 +447,7 @@ public:
             throw Error::OutOfMemory;
         }
 
-        moveTo_(newData_);
+        relocateTo_(newData_, newCapacity);
 
         allocator_.deallocate(data_, capacity_);
         data_ = newData_;
@@ -301,6 +455,43 @@ public:
         capacity_ = newCapacity;
     }
 
+    /**
+     * @brief Reduces capacity to size. Memory is freed completely for empty vector.
+     */
+    void shrink_to_fit()
+    {
+        if(capacity_ == size_) return;
+
+        if(size_ == 0)
+        {
+            allocator_.deallocate(data_, capacity_);
+            data_     = nullptr;
+            capacity_ = 0;
+            return;
+        }
+
+        if constexpr (is_trivially_relocatable_v<T> && AllocatorTraits<Allocator>::can_reallocate)
+        {
+            // Failed shrink leaves vector as is.
+            if(T* newData = allocator_.reallocate(data_, capacity_, size_))
+            {
+                data_     = newData;
+                capacity_ = size_;
+            }
+            return;
+        }
+
+        T* newData = allocator_.allocate(size_);
+        if(!newData)
+        {
+            throw Error::OutOfMemory;
+        }
+        relocateTo_(newData, size_);
+        allocator_.deallocate(data_, capacity_);
+        data_     = newData;
+        capacity_ = size_;
+    }
+
     void resize(size_t newSize, const T& fill)
     {
         if(size_ >= newSize)
@@ -316,6 +507,7 @@ public:
         }
 
         fillData_(data_ + size_, newSize - size_, fill);
+        size_ = newSize;
     }
 
     void resize(size_t newSize)
@@ -333,6 +525,7 @@ public:
         }
 
         fillDataDefault_(data_ + size_, newSize - size_);
+        size_ = newSize;
     }
 
     void assign(size_t n, const T& fill)
@@ -341,57 +534,167 @@ public:
         resize(n, fill);
     }
 
-    void clean() { resize(0);}
+    void clean()
+    {
+        eraseData_(data_, size_);
+        size_ = 0;
+    }
 
     bool empty() const {return size_ == 0;}
 
     const T& operator[](size_t i) const 
     {
-        if(i > size_)
-        {
-            throw Error::OutOfRange;
-        }
+        checkIndex_(i);
         return data_[i];
     }
 
     T& operator[](size_t i) 
     {
-        if(i > size_)
-        {
-            throw Error::OutOfRange;
-        }
+        checkIndex_(i);
         return data_[i];
     }
 
+    T*       data()       { return data_; }
+    const T* data() const { return data_; }
+
     void push_back(const T& t)
+    {
+        emplace_back(t);
+    }
+
+    void push_back(T&& t)
+    {
+        emplace_back(std::move(t));
+    }
+
+    /**
+     * @brief Constructs element at the end. Arguments may refer to elements of this vector.
+     */
+    template<class... Args>
+    T& emplace_back(Args&&... args)
     {
         if(size_ == capacity_)
         {
-            expand_();
+            emplaceGrow_(std::forward<Args>(args)...);
+        }
+        else
+        {
+            new (&data_[size_]) T(std::forward<Args>(args)...);
         }
+        return data_[size_++];
+    }
 
-        try 
+    void pop_back()
+    {
+        if(size_ == 0)
         {
-            new (&data_[size_]) T(t);
-        } catch (...)
+            throw Error::OutOfRange;
+        }
+        data_[--size_].~T();
+    }
+
+    /**
+     * @brief Inserts [first, last) before pos. Capacity is checked once, buffer is reallocated at most once.
+     *
+     * @return iterator to first inserted element.
+     */
+    template<std::input_iterator Iter>
+    iterator insert(const_iterator pos, Iter first, Iter last)
+    {
+        size_t at = indexOf_(pos);
+        if(at > size_) throw Error::OutOfRange;
+
+        // Range of this vector would be shifted under our feet.
+        if(aliases_(first, last))
         {
-            /* Really do nothing */
-            throw;
+            Vector copy(allocator_);
+            copy.insert(copy.end(), first, last);
+            return insert(pos, std::make_move_iterator(copy.data_), std::make_move_iterator(copy.data_ + copy.size_));
+        }
+
+        if constexpr (!std::forward_iterator<Iter>)
+        {
+            size_t oldSize = size_;
+            for(; first != last; ++first) emplace_back(*first);
+            std::rotate(data_ + at, data_ + oldSize, data_ + size_);
+            return iterAt_(at);
+        }
+        else
+        {
+            size_t n = static_cast<size_t>(std::distance(first, last));
+            if(n == 0) return iterAt_(at);
+
+            if(size_ + n > capacity_)
+            {
+                insertGrow_(at, n, first);
+            }
+            else if constexpr (is_trivially_relocatable_v<T>)
+            {
+                insertShift_(at, n, first);
+            }
+            else
+            {
+                size_t oldSize = size_;
+                for(; first != last; ++first) emplace_back(*first);
+                std::rotate(data_ + at, data_ + oldSize, data_ + size_);
+            }
+            return iterAt_(at);
         }
-        size_++;
     }
 
-    RAIterator<T> begin() { return RAIterator<T>(this, 0); }
-    RAIterator<T> end() { return RAIterator<T>(this, size_); }
+    /**
+     * @brief Appends elements of range. Elements of rvalue container are moved.
+     */
+    template<std::ranges::input_range Range>
+    void append(Range&& range)
+    {
+        if constexpr (std::is_rvalue_reference_v<Range&&> && !std::ranges::borrowed_range<Range>)
+            insert(end(), std::make_move_iterator(std::ranges::begin(range)), std::make_move_iterator(std::ranges::end(range)));
+        else
+            insert(end(), std::ranges::begin(range), std::ranges::end(range));
+    }
 
-    RAConstIterator<T> begin() const { return RAConstIterator<T>(this, 0); }
-    RAConstIterator<T> end() const { return RAConstIterator<T>(this, size_); }
+    /**
+     * @brief Erases [first, last). Tail is shifted down once.
+     *
+     * @return iterator to element which followed erased ones.
+     */
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        size_t from = indexOf_(first), to = indexOf_(last);
+        if(from > to || to > size_) throw Error::OutOfRange;
+        if(from == to) return iterAt_(from);
 
-    std::reverse_iterator<RAIterator<T>> rbegin() { return std::reverse_iterator<RAIterator<T>>(end()); }
-    std::reverse_iterator<RAIterator<T>> rend() { return std::reverse_iterator<RAIterator<T>>(begin()); }
+        if constexpr (is_trivially_relocatable_v<T>)
+        {
+            eraseData_(data_ + from, to - from);
+            std::memmove(static_cast<void*>(data_ + from), data_ + to, (size_ - to) * sizeof(T));
+        }
+        else
+        {
+            std::move(data_ + to, data_ + size_, data_ + from);
+            eraseData_(data_ + size_ - (to - from), to - from);
+        }
+        size_ -= to - from;
+        return iterAt_(from);
+    }
+
+    iterator erase(const_iterator pos)
+    {
+        return erase(pos, pos + 1);
+    }
 
-    std::reverse_iterator<RAConstIterator<T>> rbegin() const { return std::reverse_iterator<RAConstIterator<T>>(end()); }
-    std::reverse_iterator<RAConstIterator<T>> rend() const   { return std::reverse_iterator<RAConstIterator<T>>(begin()); }
+    iterator begin() { return iterAt_(0); }
+    iterator end() { return iterAt_(size_); }
+
+    const_iterator begin() const { return iterAt_(0); }
+    const_iterator end() const { return iterAt_(size_); }
+
+    std::reverse_iterator<iterator> rbegin() { return std::reverse_iterator<iterator>(end()); }
+    std::reverse_iterator<iterator> rend() { return std::reverse_iterator<iterator>(begin()); }
+
+    std::reverse_iterator<const_iterator> rbegin() const { return std::reverse_iterator<const_iterator>(end()); }
+    std::reverse_iterator<const_iterator> rend() const   { return std::reverse_iterator<const_iterator>(begin()); }
     
     /**
      * @brief Comarasion operator is deleted by design. We are not allowing this implict opetaion. 
@@ -406,26 +709,249 @@ private:
 
     Allocator allocator_;
 
-    void moveTo_(T* newData)
+    void checkIndex_(size_t i) const
     {
-        assert(newData != nullptr);
+        if constexpr (Access::CHECKED)
+        {
+            if(i >= size_) throw Error::OutOfRange;
+        }
+        else
+        {
+            assert(i < size_);
+        }
+    }
 
-        for(size_t i = 0; i < size_; ++i)
+    iterator iterAt_(size_t i) const
+    {
+        if constexpr (Access::CHECKED)
+            return iterator(this, i);
+        else
+            return data_ + i;
+    }
+
+    size_t indexOf_(const_iterator it) const
+    {
+        if constexpr (Access::CHECKED)
         {
+            if(it.container_ != this) throw Error::DifferentContainerIterator;
+            return it.position_;
+        }
+        else
+        {
+            return static_cast<size_t>(it - data_);
+        }
+    }
+
+    /// Iterator points into this vector.
+    bool owns_(const_iterator it) const
+    {
+        if constexpr (Access::CHECKED)
+            return it.container_ == this;
+        else
+            return std::less_equal<const T*>()(data_, it) && std::less_equal<const T*>()(it, data_ + size_);
+    }
+
+    /// Range [first, last) lies in this vector. Pointer-like iterators are checked by address.
+    template<class Iter>
+    bool aliases_(Iter first, Iter last) const
+    {
+        if constexpr (std::same_as<Iter, iterator> || std::same_as<Iter, const_iterator>)
+        {
+            return owns_(first);
+        }
+        else if constexpr (std::contiguous_iterator<Iter> && std::same_as<std::iter_value_t<Iter>, T>)
+        {
+            const T* ptr = std::to_address(first);
+            return first != last && std::less_equal<const T*>()(data_, ptr) && std::less<const T*>()(ptr, data_ + size_);
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    /// Grows full vector and constructs element at size_. Arguments may refer to old elements.
+    template<class... Args>
+    void emplaceGrow_(Args&&... args)
+    {
+        if constexpr (is_trivially_relocatable_v<T>)
+        {
+            // Element is built aside and relocated in, so reserve() may use any path.
+            alignas(T) unsigned char buf[sizeof(T)];
+            T* elem = new(buf) T(std::forward<Args>(args)...);
             try
             {
-                new(&newData[i]) T(std::move(data_[i]));
-            } catch (...) {
-                size_ = i;
-                this->~Vector();
+                expand_();
+            }
+            catch(...)
+            {
+                elem->~T();
                 throw;
             }
+            std::memcpy(static_cast<void*>(data_ + size_), buf, sizeof(T));
+        }
+        else
+        {
+            size_t newCapacity = grownCapacity_(size_ + 1);
+            T* newData = allocator_.allocate(newCapacity);
+            if(!newData) throw Error::OutOfMemory;
+
+            try
+            {
+                new(&newData[size_]) T(std::forward<Args>(args)...);
+            }
+            catch(...)
+            {
+                allocator_.deallocate(newData, newCapacity);
+                throw;
+            }
+            try
+            {
+                detail::relocate(newData, data_, size_);
+            }
+            catch(...)
+            {
+                newData[size_].~T();
+                allocator_.deallocate(newData, newCapacity);
+                throw;
+            }
+            allocator_.deallocate(data_, capacity_);
+            data_     = newData;
+            capacity_ = newCapacity;
         }
     }
 
+    /// Constructs n elements from first at dst. On exception constructed ones are destroyed.
+    template<class Iter>
+    static void constructRange_(T* dst, size_t n, Iter first)
+    {
+        size_t i = 0;
+        try
+        {
+            for(; i < n; ++i, ++first) new(&dst[i]) T(*first);
+        }
+        catch(...)
+        {
+            for(size_t j = 0; j < i; ++j) dst[j].~T();
+            throw;
+        }
+    }
+
+    /// Inserts n elements into new buffer: new ones are constructed first, so failure leaves vector intact.
+    template<class Iter>
+    void insertGrow_(size_t at, size_t n, Iter first)
+    {
+        size_t newCapacity = grownCapacity_(size_ + n);
+        T* newData = allocator_.allocate(newCapacity);
+        if(!newData) throw Error::OutOfMemory;
+
+        try
+        {
+            constructRange_(newData + at, n, first);
+        }
+        catch(...)
+        {
+            allocator_.deallocate(newData, newCapacity);
+            throw;
+        }
+
+        if constexpr (is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T>)
+        {
+            detail::relocate(newData, data_, at);
+            detail::relocate(newData + at + n, data_ + at, size_ - at);
+        }
+        else
+        {
+            // Old elements are destroyed only when both parts are built, so failure leaves vector intact.
+            try
+            {
+                detail::uninitialized_move_if_noexcept(newData, data_, at);
+                try
+                {
+                    detail::uninitialized_move_if_noexcept(newData + at + n, data_ + at, size_ - at);
+                }
+                catch(...)
+                {
+                    eraseData_(newData, at);
+                    throw;
+                }
+            }
+            catch(...)
+            {
+                eraseData_(newData + at, n);
+                allocator_.deallocate(newData, newCapacity);
+                throw;
+            }
+            eraseData_(data_, size_);
+        }
+
+        allocator_.deallocate(data_, capacity_);
+        data_     = newData;
+        capacity_ = newCapacity;
+        size_    += n;
+    }
+
+    /// Inserts n elements in place by moving tail bytes up. Needs spare capacity.
+    template<class Iter>
+    void insertShift_(size_t at, size_t n, Iter first)
+    {
+        detail::relocate(data_ + at + n, data_ + at, size_ - at);
+        try
+        {
+            constructRange_(data_ + at, n, first);
+        }
+        catch(...)
+        {
+            detail::relocate(data_ + at, data_ + at + n, size_ - at);
+            throw;
+        }
+        size_ += n;
+    }
+
+    /// Relocates elements into new buffer of given capacity, which is freed if that throws.
+    void relocateTo_(T* newData, size_t newCapacity)
+    {
+        assert(newData != nullptr);
+        if(!data_) return; // Vector without buffer is empty.
+        try
+        {
+            detail::relocate(newData, data_, size_);
+        }
+        catch(...)
+        {
+            allocator_.deallocate(newData, newCapacity);
+            throw;
+        }
+    }
+
+    static bool isZeroBytes_(const T& elem)
+    {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char* >(&elem);
+        for(size_t i = 0; i < sizeof(T); ++i)
+        {
+            if(bytes[i]) return false;
+        }
+        return true;
+    }
+
     void fillData_(T* data, size_t n, const T& fillElem)
     {
         assert(data != nullptr || n == 0);
+
+        if constexpr (std::is_trivially_copyable<T>::value)
+        {
+            if(n && (sizeof(T) == 1 || isZeroBytes_(fillElem)))
+            {
+                std::memset(static_cast<void*>(data), *reinterpret_cast<const unsigned char* >(&fillElem), n * sizeof(T));
+                return;
+            }
+            for(size_t i = 0; i < n; ++i)
+            {
+                new(&data[i]) T(fillElem);
+            }
+            return;
+        }
+
         for(size_t i = 0; i < n; ++i)
         {   
             try { 
@@ -441,6 +967,8 @@ private:
     void fillDataDefault_(T* data, size_t n) 
     {
         assert(data != nullptr || n == 0);
+        if constexpr (std::is_trivially_default_constructible<T>::value) return;
+
         for(size_t i = 0; i < n; ++i)
         {
             try {
@@ -456,6 +984,7 @@ private:
     void eraseData_(T* data, size_t n) noexcept(true)
     {
         assert(data != nullptr || n == 0);
+        if constexpr (std::is_trivially_destructible<T>::value) return;
 
         for(size_t i = 0; i < n; ++i)
         {
@@ -466,6 +995,12 @@ private:
     void copyFrom_(T* othData)
     {
         assert(othData != nullptr || size_ == 0);
+
+        if constexpr (std::is_trivially_copyable<T>::value)
+        {
+            if(size_) std::memcpy(static_cast<void*>(data_), othData, size_ * sizeof(T));
+            return;
+        }
         for(size_t i = 0; i < size_; ++i)
         {
             try
@@ -481,25 +1016,30 @@ private:
         }
     }
 
+    size_t grownCapacity_(size_t required) const
+    {
+        return Growth::template grow<T>(allocator_, capacity_, required);
+    }
+
     void expand_()
     {
-        reserve(2 * size_ + 1);
+        reserve(grownCapacity_(size_ + 1));
     }
 };
-template<class T>
-RAIterator<T> operator+(const RAIterator<T>& iter, ptrdiff_t diff)
+template<class T, class Container>
+RAIterator<T, Container> operator+(const RAIterator<T, Container>& iter, ptrdiff_t diff)
 {
-    return RAIterator<T>(iter) += diff;
+    return RAIterator<T, Container>(iter) += diff;
 }
 
-template<class T>
-RAIterator<T> operator+(ptrdiff_t shift, const RAIterator<T>& other)
+template<class T, class Container>
+RAIterator<T, Container> operator+(ptrdiff_t shift, const RAIterator<T, Container>& other)
 {
     return other + shift;
 }
 
-template<class T>
-RAConstIterator<T> operator+(ptrdiff_t shift, const RAConstIterator<T>& other)
+template<class T, class Container>
+RAConstIterator<T, Container> operator+(ptrdiff_t shift, const RAConstIterator<T, Container>& other)
 {
     return other + shift;
 }
@@ -0,0 +1,323 @@
+#ifndef MGKTL_MDATA_VECTOREXPR_HPP
+#define MGKTL_MDATA_VECTOREXPR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "Vector.hpp"
+
+// Element-wise loops read and write same index only, so stores never feed later loads.
+#if defined(__clang__)
+#define MGK_EXPR_IVDEP _Pragma("clang loop vectorize(assume_safety)")
+#elif defined(__GNUC__)
+#define MGK_EXPR_IVDEP _Pragma("GCC ivdep")
+#else
+#define MGK_EXPR_IVDEP
+#endif
+
+namespace mgk {
+
+namespace detail {
+
+    template<class V>
+    struct IsVector : std::false_type {};
+
+    template<class T, class Allocator, class Access, class Growth>
+    struct IsVector<Vector<T, Allocator, Access, Growth>> : std::true_type {};
+
+}
+
+/// Part of ExprBase common to all nodes, so one Error type is caught for any expression.
+struct ExprCommon
+{
+    enum class Error
+    {
+        OutOfRange,
+    };
+};
+
+/**
+ * @brief Base of lazy expression nodes. Result is computed element by element when expression is assigned to
+ * Vector, so whole expression runs as one loop and no temporary vectors are created.
+ */
+template<class Derived>
+class ExprBase : public ExprCommon
+{
+public:
+    static constexpr size_t BLOCK = 16;
+
+    template<class Out>
+    void evaluateInto(Out* dst, size_t first, size_t last) const
+    {
+        const Derived& self = static_cast<const Derived&>(*this);
+        size_t i = first;
+        // Fixed trip count of inner loop lets it be vectorized without scalar epilogue, which -O2 requires.
+        for(; i + BLOCK <= last; i += BLOCK)
+        {
+            MGK_EXPR_IVDEP
+            for(size_t j = i; j < i + BLOCK; ++j)
+            {
+                dst[j] = static_cast<Out>(self[j]);
+            }
+        }
+        for(; i < last; ++i)
+        {
+            dst[i] = static_cast<Out>(self[i]);
+        }
+    }
+};
+
+/**
+ * @brief Vector of arithmetic values. Expressions refer to it, so it must outlive them.
+ */
+template<class V>
+concept ArithmeticVector = detail::IsVector<std::remove_cvref_t<V>>::value &&
+                           std::is_arithmetic_v<typename std::remove_cvref_t<V>::value_type>;
+
+template<class E>
+concept ExprNode = std::is_base_of_v<ExprBase<std::remove_cvref_t<E>>, std::remove_cvref_t<E>>;
+
+template<class E>
+concept ExprOperand = ArithmeticVector<E> || ExprNode<E>;
+
+/// Leaf which reads elements of vector.
+template<class T>
+class VectorTerm
+{
+public:
+    using value_type = T;
+
+    VectorTerm(const T* data, size_t size) : data_(data), size_(size) {}
+
+    size_t size() const { return size_; }
+
+    T operator[](size_t i) const { return data_[i]; }
+
+private:
+    const T* data_;
+    size_t   size_;
+};
+
+/// Leaf which repeats one value. It takes size of other operand.
+template<class T>
+class ScalarTerm
+{
+public:
+    using value_type = T;
+
+    explicit ScalarTerm(T value) : value_(value) {}
+
+    T operator[](size_t) const { return value_; }
+
+private:
+    T value_;
+};
+
+template<class Op, class L, class R>
+class BinaryExpr : public ExprBase<BinaryExpr<Op, L, R>>
+{
+public:
+    using value_type = std::common_type_t<typename L::value_type, typename R::value_type>;
+
+    BinaryExpr(const L& lhs, const R& rhs) : lhs_(lhs), rhs_(rhs)
+    {
+        if constexpr (!IS_SCALAR<L> && !IS_SCALAR<R>)
+        {
+            if(lhs_.size() != rhs_.size()) throw ExprCommon::Error::OutOfRange;
+        }
+    }
+
+    size_t size() const
+    {
+        if constexpr (IS_SCALAR<L>) return rhs_.size();
+        else                        return lhs_.size();
+    }
+
+    value_type operator[](size_t i) const
+    {
+        return static_cast<value_type>(Op{}(lhs_[i], rhs_[i]));
+    }
+
+private:
+    template<class E>
+    static constexpr bool IS_SCALAR = std::is_same_v<E, ScalarTerm<typename E::value_type>>;
+
+    // Operands are kept by value: leaves are pointer and size, inner nodes are temporaries of full expression.
+    L lhs_;
+    R rhs_;
+};
+
+template<class Op, class E>
+class UnaryExpr : public ExprBase<UnaryExpr<Op, E>>
+{
+public:
+    using value_type = typename E::value_type;
+
+    explicit UnaryExpr(const E& operand) : operand_(operand) {}
+
+    size_t size() const { return operand_.size(); }
+
+    value_type operator[](size_t i) const
+    {
+        return static_cast<value_type>(Op{}(operand_[i]));
+    }
+
+private:
+    E operand_;
+};
+
+/**
+ * @brief Expression evaluated by several threads, each writes its own range of result.
+ */
+template<class E>
+class ParallelExpr
+{
+public:
+    using value_type = typename E::value_type;
+
+    /// Smaller ranges are not worth starting a thread.
+    static constexpr size_t MIN_CHUNK = size_t(1) << 15;
+
+    ParallelExpr(const E& expr, size_t nThreads) : expr_(expr), nThreads_(nThreads) {}
+
+    size_t size() const { return expr_.size(); }
+
+    template<class Out>
+    void evaluateInto(Out* dst, size_t first, size_t last) const
+    {
+        size_t n        = last - first;
+        size_t nThreads = std::min(nThreads_, n / MIN_CHUNK);
+        if(nThreads <= 1)
+        {
+            expr_.evaluateInto(dst, first, last);
+            return;
+        }
+
+        // Chunks are rounded to cache lines, so threads do not write to same line.
+        constexpr size_t LINE = std::max<size_t>(64 / sizeof(Out), 1);
+        size_t chunk = ((n + nThreads - 1) / nThreads + LINE - 1) / LINE * LINE;
+
+        std::vector<std::thread> threads;
+        threads.reserve(nThreads - 1);
+        try
+        {
+            for(size_t begin = first + chunk; begin < last; begin += chunk)
+            {
+                threads.emplace_back([this, dst, begin, end = std::min(begin + chunk, last)]
+                {
+                    expr_.evaluateInto(dst, begin, end);
+                });
+            }
+        }
+        catch(...)
+        {
+            for(auto& thread : threads) thread.join();
+            throw;
+        }
+
+        expr_.evaluateInto(dst, first, std::min(first + chunk, last));
+        for(auto& thread : threads) thread.join();
+    }
+
+private:
+    E      expr_;
+    size_t nThreads_;
+};
+
+namespace detail {
+
+    template<ArithmeticVector V>
+    auto asOperand(const V& vector)
+    {
+        return VectorTerm<typename V::value_type>(vector.data(), vector.size());
+    }
+
+    template<ExprNode E>
+    const E& asOperand(const E& expr)
+    {
+        return expr;
+    }
+
+    template<class E>
+    using OperandType = std::remove_cvref_t<decltype(asOperand(std::declval<const E&>()))>;
+
+    template<class Op, ExprOperand L, ExprOperand R>
+    auto makeBinary(const L& lhs, const R& rhs)
+    {
+        return BinaryExpr<Op, OperandType<L>, OperandType<R>>(asOperand(lhs), asOperand(rhs));
+    }
+
+    /// Scalar takes value type of vector operand, so float vectors stay float. Integers meet fractions in floating point.
+    template<class T, class S>
+    using ScalarType = std::conditional_t<std::is_integral_v<T> && std::is_floating_point_v<S>, std::common_type_t<T, S>, T>;
+
+    template<class Op, ExprOperand L, class S>
+    auto makeBinaryScalar(const L& lhs, S rhs)
+    {
+        using T = ScalarType<typename OperandType<L>::value_type, S>;
+        return BinaryExpr<Op, OperandType<L>, ScalarTerm<T>>(asOperand(lhs), ScalarTerm<T>(static_cast<T>(rhs)));
+    }
+
+    template<class Op, class S, ExprOperand R>
+    auto makeScalarBinary(S lhs, const R& rhs)
+    {
+        using T = ScalarType<typename OperandType<R>::value_type, S>;
+        return BinaryExpr<Op, ScalarTerm<T>, OperandType<R>>(ScalarTerm<T>(static_cast<T>(lhs)), asOperand(rhs));
+    }
+
+}
+
+#define MGK_EXPR_BINARY_OPERATOR(op, Functor)                                                       \
+    template<ExprOperand L, ExprOperand R>                                                          \
+    auto operator op(const L& lhs, const R& rhs)                                                    \
+    {                                                                                               \
+        return detail::makeBinary<Functor>(lhs, rhs);                                               \
+    }                                                                                               \
+                                                                                                    \
+    template<ExprOperand L, class S>                                                                \
+    requires std::is_arithmetic_v<S>                                                                \
+    auto operator op(const L& lhs, S rhs)                                                           \
+    {                                                                                               \
+        return detail::makeBinaryScalar<Functor>(lhs, rhs);                                         \
+    }                                                                                               \
+                                                                                                    \
+    template<class S, ExprOperand R>                                                                \
+    requires std::is_arithmetic_v<S>                                                                \
+    auto operator op(S lhs, const R& rhs)                                                           \
+    {                                                                                               \
+        return detail::makeScalarBinary<Functor>(lhs, rhs);                                         \
+    }
+
+MGK_EXPR_BINARY_OPERATOR(+, std::plus<>)
+MGK_EXPR_BINARY_OPERATOR(-, std::minus<>)
+MGK_EXPR_BINARY_OPERATOR(*, std::multiplies<>)
+MGK_EXPR_BINARY_OPERATOR(/, std::divides<>)
+
+#undef MGK_EXPR_BINARY_OPERATOR
+
+template<ExprOperand E>
+auto operator-(const E& operand)
+{
+    return UnaryExpr<std::negate<>, detail::OperandType<E>>(detail::asOperand(operand));
+}
+
+/**
+ * @brief Marks expression for evaluation by nThreads threads, 0 means all hardware threads.
+ * Vectors shorter than ParallelExpr::MIN_CHUNK * 2 are still evaluated by calling thread.
+ */
+template<ExprNode E>
+ParallelExpr<E> parallel(const E& expr, size_t nThreads = 0)
+{
+    if(nThreads == 0) nThreads = std::max(1u, std::thread::hardware_concurrency());
+    return ParallelExpr<E>(expr, nThreads);
+}
+
+}
+
+#undef MGK_EXPR_IVDEP
+
+#endif /* MGKTL_MDATA_VECTOREXPR_HPP */
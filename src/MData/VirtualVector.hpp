@@ -0,0 +1,254 @@
+#ifndef MGKTL_MDATA_VIRTUALVECTOR_HPP
+#define MGKTL_MDATA_VIRTUALVECTOR_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "Vector.hpp"
+
+namespace mgk {
+
+/**
+ * @brief Vector over address range reserved up front. Pages are committed as size grows, so elements never move
+ * and pointers to them stay valid until they are erased.
+ *
+ * Reserved range is PROT_NONE mapping of maxSize elements, it costs address space only. Committed part grows
+ * twice at a time, untouched committed pages are not backed by memory either. decommit() gives pages above
+ * size back to system.
+ */
+template<class T>
+requires std::destructible<T>
+class VirtualVector
+{
+public:
+    enum class Error
+    {
+        Ok,
+        OutOfRange,
+        OutOfMemory,
+        BadObject,
+        DifferentContainerIterator,
+    };
+
+    using iterator       = RAIterator<T, VirtualVector>;
+    using const_iterator = RAConstIterator<T, VirtualVector>;
+
+    static constexpr size_t DEFAULT_RESERVE = size_t(64) << 30;
+
+    explicit VirtualVector(size_t maxSize = DEFAULT_RESERVE / sizeof(T)) :
+        reserved_(roundToPage_(std::max<size_t>(maxSize, 1) * sizeof(T)))
+    {
+        if(maxSize > SIZE_MAX / 2 / sizeof(T)) throw Error::OutOfMemory;
+
+        void* mem = mmap(nullptr, reserved_, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if(mem == MAP_FAILED) throw Error::OutOfMemory;
+        data_ = static_cast<T*>(mem);
+    }
+
+    VirtualVector(const VirtualVector& oth) : VirtualVector(oth.max_size())
+    {
+        *this = oth;
+    }
+
+    VirtualVector& operator=(const VirtualVector& oth)
+    {
+        if(this == &oth) return *this;
+
+        clean();
+        reserve(oth.size_);
+        for(; size_ < oth.size_; ++size_)
+        {
+            new(&data_[size_]) T(oth.data_[size_]);
+        }
+        return *this;
+    }
+
+    /// Moved-from vector keeps no reservation, max_size() of it is 0.
+    VirtualVector(VirtualVector&& oth) : data_(nullptr), size_(0), committed_(0), reserved_(0)
+    {
+        swap(oth);
+    }
+
+    VirtualVector& operator=(VirtualVector&& oth)
+    {
+        swap(oth);
+        return *this;
+    }
+
+    ~VirtualVector()
+    {
+        clean();
+        if(data_) munmap(data_, reserved_);
+        data_ = nullptr;
+    }
+
+    void swap(VirtualVector& other)
+    {
+        std::swap(data_     , other.data_);
+        std::swap(size_     , other.size_);
+        std::swap(committed_, other.committed_);
+        std::swap(reserved_ , other.reserved_);
+    }
+
+    size_t size()     const { return size_; }
+    size_t capacity() const { return committed_ / sizeof(T); }
+    size_t max_size() const { return reserved_ / sizeof(T); }
+    bool   empty()    const { return size_ == 0; }
+
+    T*       data()       { return data_; }
+    const T* data() const { return data_; }
+
+    bool validate() const noexcept(true)
+    {
+        return (data_ != nullptr || reserved_ == 0) && size_ <= capacity() && committed_ <= reserved_;
+    }
+
+    void validateThrow() const noexcept(false)
+    {
+        if(!validate()) throw Error::BadObject;
+    }
+
+    /**
+     * @brief Commits pages for newCapacity elements. Elements are not moved.
+     */
+    void reserve(size_t newCapacity)
+    {
+        if(newCapacity <= capacity()) return;
+        if(newCapacity > max_size()) throw Error::OutOfMemory;
+
+        size_t bytes = std::min(reserved_, std::max(roundToPage_(newCapacity * sizeof(T)), 2 * committed_));
+        char*  base  = reinterpret_cast<char* >(data_);
+        if(mprotect(base + committed_, bytes - committed_, PROT_READ | PROT_WRITE) != 0)
+        {
+            throw Error::OutOfMemory;
+        }
+        committed_ = bytes;
+    }
+
+    /**
+     * @brief Returns committed pages above size to system. Their addresses stay reserved.
+     */
+    void decommit()
+    {
+        size_t keep = roundToPage_(size_ * sizeof(T));
+        if(keep == committed_) return;
+
+        char* base = reinterpret_cast<char* >(data_);
+        madvise(base + keep, committed_ - keep, MADV_DONTNEED);
+        mprotect(base + keep, committed_ - keep, PROT_NONE);
+        committed_ = keep;
+    }
+
+    void resize(size_t newSize, const T& fill)
+    {
+        shrink_(newSize);
+        reserve(newSize);
+        for(; size_ < newSize; ++size_)
+        {
+            new(&data_[size_]) T(fill);
+        }
+    }
+
+    void resize(size_t newSize)
+    {
+        shrink_(newSize);
+        reserve(newSize);
+        if constexpr (std::is_trivially_default_constructible<T>::value)
+        {
+            size_ = std::max(size_, newSize);
+            return;
+        }
+        for(; size_ < newSize; ++size_)
+        {
+            new(&data_[size_]) T;
+        }
+    }
+
+    void assign(size_t n, const T& fill)
+    {
+        clean();
+        resize(n, fill);
+    }
+
+    void clean() { shrink_(0); }
+
+    const T& operator[](size_t i) const
+    {
+        if(i >= size_)
+        {
+            throw Error::OutOfRange;
+        }
+        return data_[i];
+    }
+
+    T& operator[](size_t i)
+    {
+        if(i >= size_)
+        {
+            throw Error::OutOfRange;
+        }
+        return data_[i];
+    }
+
+    void push_back(const T& t)
+    {
+        if(size_ == capacity())
+        {
+            reserve(size_ + 1);
+        }
+
+        new (&data_[size_]) T(t);
+        size_++;
+    }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, size_); }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size_); }
+
+    std::reverse_iterator<iterator> rbegin() { return std::reverse_iterator<iterator>(end()); }
+    std::reverse_iterator<iterator> rend() { return std::reverse_iterator<iterator>(begin()); }
+
+    std::reverse_iterator<const_iterator> rbegin() const { return std::reverse_iterator<const_iterator>(end()); }
+    std::reverse_iterator<const_iterator> rend() const   { return std::reverse_iterator<const_iterator>(begin()); }
+
+    bool operator==(const VirtualVector&) = delete;
+
+private:
+    T* data_ = nullptr;
+
+    size_t size_      = 0;
+    size_t committed_ = 0; ///< Bytes.
+    size_t reserved_  = 0; ///< Bytes.
+
+    static size_t roundToPage_(size_t bytes)
+    {
+        static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return (bytes + pageSize - 1) / pageSize * pageSize;
+    }
+
+    void shrink_(size_t newSize)
+    {
+        if constexpr (!std::is_trivially_destructible<T>::value)
+        {
+            for(size_t i = newSize; i < size_; ++i)
+            {
+                data_[i].~T();
+            }
+        }
+        size_ = std::min(size_, newSize);
+    }
+};
+
+}
+
+#endif /* MGKTL_MDATA_VIRTUALVECTOR_HPP */
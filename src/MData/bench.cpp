@@ -0,0 +1,483 @@
+#include "Allocator.hpp"
+#include "BucketArray.hpp"
+#include "RingBuffer.hpp"
+#include "ConcurrentBucketAllocator.hpp"
+#include "SimdAlgorithms.hpp"
+#include "SmallVector.hpp"
+#include "SoAVector.hpp"
+#include "ThreadCachingAllocator.hpp"
+#include "Vector.hpp"
+#include "VectorExpr.hpp"
+#include "VirtualVector.hpp"
+#include <MIo/stream.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Node
+{
+    uint64_t key;
+    Node*    left;
+    Node*    right;
+};
+
+template<class T>
+class LockedBucketAllocator
+{
+public:
+    using value_type = T;
+
+    LockedBucketAllocator() : lock_(), pool_() {}
+
+    [[nodiscard]]
+    T* allocate()
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        return pool_.allocate();
+    }
+
+    void deallocate(T* elem)
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        pool_.deallocate(elem);
+    }
+
+private:
+    std::mutex lock_;
+    mgk::BucketAllocator<T> pool_;
+};
+
+const size_t BATCH_SZ = 256;
+const size_t N_ROUNDS = 4096;
+
+/**
+ * @brief Every thread allocates batch of nodes, touches them and frees them back. Returns ops per ms.
+ */
+template<class Alloc>
+uint64_t runAllocFree(Alloc& alloc, size_t nThreads)
+{
+    auto worker = [&alloc] {
+        Node* batch[BATCH_SZ] = {};
+        for(size_t round = 0; round < N_ROUNDS; ++round)
+        {
+            for(size_t i = 0; i < BATCH_SZ; ++i)
+            {
+                batch[i] = alloc.allocate();
+                batch[i]->key = i;
+            }
+            for(size_t i = 0; i < BATCH_SZ; ++i)
+            {
+                alloc.deallocate(batch[i]);
+            }
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for(size_t i = 0; i < nThreads; ++i)
+    {
+        threads.emplace_back(worker);
+    }
+    for(auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    auto time = std::chrono::steady_clock::now() - start;
+    uint64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(time).count() + 1;
+    return 2 * BATCH_SZ * N_ROUNDS * nThreads / ms;
+}
+
+std::vector<size_t> threadCounts()
+{
+    size_t nCores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<size_t> counts;
+    for(size_t n = 1; n < nCores; n *= 2)
+    {
+        counts.push_back(n);
+    }
+    counts.push_back(nCores);
+    return counts;
+}
+
+void benchThreadCaching()
+{
+    mgk::out << "=== Alloc/free, ops per ms ===\n";
+    mgk::out << "threads | mutex + BucketAllocator | ThreadCachingAllocator\n";
+    for(size_t nThreads : threadCounts())
+    {
+        LockedBucketAllocator<Node> locked;
+        mgk::ThreadCachingAllocator<Node> caching;
+
+        uint64_t lockedOps  = runAllocFree(locked,  nThreads);
+        uint64_t cachingOps = runAllocFree(caching, nThreads);
+
+        mgk::out << nThreads << " | " << lockedOps << " | " << cachingOps << '\n';
+    }
+    mgk::out.flush();
+}
+
+void benchConcurrentBucket()
+{
+    mgk::out << "=== Shared node pool alloc/free, ops per ms ===\n";
+    mgk::out << "threads | mutex + BucketAllocator | ConcurrentBucketAllocator\n";
+    for(size_t nThreads : {1, 2, 4, 8, 16})
+    {
+        LockedBucketAllocator<Node> locked;
+        mgk::ConcurrentBucketAllocator<Node> lockFree;
+
+        uint64_t lockedOps   = runAllocFree(locked,   nThreads);
+        uint64_t lockFreeOps = runAllocFree(lockFree, nThreads);
+
+        mgk::out << nThreads << " | " << lockedOps << " | " << lockFreeOps << '\n';
+    }
+    mgk::out.flush();
+}
+
+void benchBatch()
+{
+    mgk::out << "=== BucketAllocator batch of " << BATCH_SZ << " nodes, ops per ms ===\n";
+    mgk::out << "allocate/deallocate | allocate_n/deallocate_batch\n";
+
+    mgk::BucketAllocator<Node> alloc;
+    Node* batch[BATCH_SZ] = {};
+
+    auto start = std::chrono::steady_clock::now();
+    for(size_t round = 0; round < N_ROUNDS; ++round)
+    {
+        for(Node*& node : batch) node = alloc.allocate();
+        for(Node*  node : batch) alloc.deallocate(node);
+    }
+    auto single = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for(size_t round = 0; round < N_ROUNDS; ++round)
+    {
+        alloc.allocate_n(BATCH_SZ, batch);
+        alloc.deallocate_batch(batch);
+    }
+    auto batched = std::chrono::steady_clock::now() - start;
+
+    auto opsPerMs = [](auto time) {
+        uint64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(time).count() + 1;
+        return 2 * BATCH_SZ * N_ROUNDS / ms;
+    };
+    mgk::out << opsPerMs(single) << " | " << opsPerMs(batched) << '\n';
+    mgk::out.flush();
+}
+
+/// Milliseconds taken by f.
+template<class F>
+uint64_t timeMs(F&& f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto time = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time).count();
+}
+
+void benchVectorGrowth()
+{
+    const size_t n = 1 << 25;
+    mgk::out << "=== push_back of " << n << " uint64_t, ms ===\n";
+    mgk::out << "mgk::Vector | Vector + Mallocator (realloc) | Vector + MmapAllocator (mremap) | VirtualVector | std::vector\n";
+
+    auto grow = [n](auto& v) {
+        for(size_t i = 0; i < n; ++i) v.push_back(i);
+    };
+
+    uint64_t vectorMs = timeMs([&grow] { mgk::Vector<uint64_t> v; grow(v); });
+    uint64_t mallocMs = timeMs([&grow] { mgk::Vector<uint64_t, mgk::Mallocator<uint64_t>> v; grow(v); });
+    uint64_t mmapMs   = timeMs([&grow] { mgk::Vector<uint64_t, mgk::MmapAllocator<uint64_t>> v; grow(v); });
+    uint64_t virtMs   = timeMs([&grow] { mgk::VirtualVector<uint64_t> v; grow(v); });
+    uint64_t stdMs    = timeMs([&grow] { std::vector<uint64_t> v; grow(v); });
+
+    mgk::out << vectorMs << " | " << mallocMs << " | " << mmapMs << " | " << virtMs << " | " << stdMs << '\n';
+    mgk::out.flush();
+}
+
+/**
+ * @brief Creates many short-lived containers of given size. Returns containers per ms.
+ */
+template<class Container>
+uint64_t runSmallContainers(size_t size)
+{
+    const size_t nContainers = 1 << 18;
+    uint64_t checksum = 0;
+    uint64_t ms = timeMs([&] {
+        for(size_t k = 0; k < nContainers; ++k)
+        {
+            Container c;
+            for(size_t i = 0; i < size; ++i) c.push_back(i);
+            checksum += c.size();
+        }
+    });
+    assert(checksum == nContainers * size);
+    return nContainers / (ms + 1);
+}
+
+void benchSmallVector()
+{
+    mgk::out << "=== Short-lived containers of uint64_t, containers per ms ===\n";
+    mgk::out << "size | Vector | SmallVector<8> | SmallVector<32>\n";
+    for(size_t size : {0, 1, 2, 4, 8, 16, 32, 64})
+    {
+        mgk::out << size << " | " << runSmallContainers<mgk::Vector<uint64_t>>(size)
+                         << " | " << runSmallContainers<mgk::SmallVector<uint64_t, 8>>(size)
+                         << " | " << runSmallContainers<mgk::SmallVector<uint64_t, 32>>(size) << '\n';
+    }
+    mgk::out.flush();
+}
+
+/// Sum by iterators, find of missing value and sort, ms.
+template<class Container>
+uint64_t runTightLoops(Container& c, uint64_t& sink)
+{
+    return timeMs([&] {
+        for(size_t round = 0; round < 16; ++round)
+        {
+            uint64_t sum = 0;
+            for(auto it = c.begin(); it != c.end(); ++it) sum += *it;
+            sink += sum + (std::find(c.begin(), c.end(), UINT64_MAX) - c.begin());
+        }
+        std::sort(c.begin(), c.end());
+    });
+}
+
+void benchAccessPolicy()
+{
+    const size_t n = 1 << 22;
+    mgk::out << "=== Sum, find and sort over " << n << " uint64_t, ms ===\n";
+    mgk::out << "CheckedAccess | UncheckedAccess | std::vector\n";
+
+    using Checked   = mgk::Vector<uint64_t, mgk::DefaultDynamicAllocator<uint64_t>, mgk::CheckedAccess>;
+    using Unchecked = mgk::Vector<uint64_t, mgk::DefaultDynamicAllocator<uint64_t>, mgk::UncheckedAccess>;
+
+    Checked   checked;
+    Unchecked unchecked;
+    std::vector<uint64_t> raw;
+    for(uint64_t i = 0; i < n; ++i)
+    {
+        uint64_t key = (i * 0x9E3779B97F4A7C15ull) >> 20;
+        checked.push_back(key);
+        unchecked.push_back(key);
+        raw.push_back(key);
+    }
+
+    uint64_t sink = 0;
+    uint64_t checkedMs   = runTightLoops(checked, sink);
+    uint64_t uncheckedMs = runTightLoops(unchecked, sink);
+    uint64_t rawMs       = runTightLoops(raw, sink);
+
+    mgk::out << checkedMs << " | " << uncheckedMs << " | " << rawMs << " (" << sink % 2 << ")\n";
+    mgk::out.flush();
+}
+
+template<class T>
+uint64_t runColumnScan(const mgk::Vector<T>& column, uint64_t& sink)
+{
+    return timeMs([&]
+    {
+        for(int rep = 0; rep < 20; ++rep)
+        {
+            auto bounds = mgk::simd::minmax(column);
+            sink += static_cast<uint64_t>(mgk::simd::sum(column)) + mgk::simd::count(column, T(7)) +
+                    mgk::simd::find(column, T(1000)) + static_cast<uint64_t>(bounds->second - bounds->first) +
+                    static_cast<uint64_t>(mgk::simd::dot(column, column));
+        }
+    });
+}
+
+template<class T>
+void benchColumn(const char* name, size_t n)
+{
+    mgk::Vector<T> column;
+    for(size_t i = 0; i < n; ++i)
+    {
+        column.push_back(static_cast<T>(static_cast<uint32_t>(i * 2654435761u) >> 24));
+    }
+
+    uint64_t sink = 0;
+    const mgk::simd::Isa best = mgk::simd::activeIsa();
+    mgk::out << name;
+    for(auto isa : {mgk::simd::Isa::Scalar, mgk::simd::Isa::Avx2, mgk::simd::Isa::Avx512})
+    {
+        if(mgk::simd::setIsa(isa) != isa)
+        {
+            mgk::out << " | -";
+            continue;
+        }
+        mgk::out << " | " << runColumnScan(column, sink);
+    }
+    mgk::simd::setIsa(best);
+    mgk::out << " (" << sink % 2 << ")\n";
+}
+
+void benchSimdAlgorithms()
+{
+    const size_t n = 1 << 22;
+    mgk::out << "=== find, count, minmax, sum and dot over " << n << " elements x20, ms ===\n";
+    mgk::out << "type | Scalar | AVX2 | AVX-512\n";
+    benchColumn<uint32_t>("uint32_t", n);
+    benchColumn<float>("float", n);
+    mgk::out.flush();
+}
+
+void benchVectorExpressions()
+{
+    const size_t n = 1 << 22;
+    mgk::out << "=== r = a + b * c - 2 over " << n << " doubles x20, ms ===\n";
+    mgk::out << "temporary per step | hand-written loop | expression | parallel expression\n";
+
+    mgk::Vector<double> a(n, 1.0), b(n, 2.0), c(n, 3.0), r(n);
+
+    auto step = [](const mgk::Vector<double>& x, const mgk::Vector<double>& y, auto op) {
+        mgk::Vector<double> tmp(x.size());
+        for(size_t i = 0; i < x.size(); ++i) tmp.data()[i] = op(x.data()[i], y.data()[i]);
+        return tmp;
+    };
+    uint64_t tempMs = timeMs([&] {
+        mgk::Vector<double> two(n, 2.0);
+        for(int rep = 0; rep < 20; ++rep)
+        {
+            r = step(step(a, step(b, c, std::multiplies<>()), std::plus<>()), two, std::minus<>());
+        }
+    });
+    uint64_t loopMs = timeMs([&] {
+        for(int rep = 0; rep < 20; ++rep)
+        {
+            double* out = r.data();
+            for(size_t i = 0; i < n; ++i) out[i] = a.data()[i] + b.data()[i] * c.data()[i] - 2;
+        }
+    });
+    uint64_t exprMs = timeMs([&] {
+        for(int rep = 0; rep < 20; ++rep) r = a + b * c - 2;
+    });
+    uint64_t parallelMs = timeMs([&] {
+        for(int rep = 0; rep < 20; ++rep) r = mgk::parallel(a + b * c - 2);
+    });
+
+    mgk::out << tempMs << " | " << loopMs << " | " << exprMs << " | " << parallelMs
+             << " (" << static_cast<uint64_t>(r[n - 1]) << ")\n";
+    mgk::out.flush();
+}
+
+struct Particle
+{
+    double x, y, z;
+    double vx, vy, vz;
+    double mass, charge;
+};
+
+void benchSoAVector()
+{
+    const size_t n = 1 << 21;
+    mgk::out << "=== x += vx over " << n << " particles of 8 doubles x20, ms ===\n";
+    mgk::out << "Vector<Particle> | SoAVector\n";
+
+    mgk::Vector<Particle> aos;
+    mgk::SoAVector<double, double, double, double, double, double, double, double> soa;
+    for(size_t i = 0; i < n; ++i)
+    {
+        double v = static_cast<double>(i % 13);
+        aos.push_back(Particle{0, 0, 0, v, v, v, 1, 1});
+        soa.push_back(0.0, 0.0, 0.0, v, v, v, 1.0, 1.0);
+    }
+
+    uint64_t aosMs = timeMs([&] {
+        for(int rep = 0; rep < 20; ++rep)
+        {
+            Particle* p = aos.data();
+            for(size_t i = 0; i < n; ++i) p[i].x += p[i].vx;
+        }
+    });
+    uint64_t soaMs = timeMs([&] {
+        for(int rep = 0; rep < 20; ++rep)
+        {
+            std::span<double> x = soa.column<0>();
+            std::span<const double> vx = soa.column<3>();
+            for(size_t i = 0; i < n; ++i) x[i] += vx[i];
+        }
+    });
+
+    mgk::out << aosMs << " | " << soaMs << " (" << static_cast<uint64_t>(aos.data()[n - 1].x + soa.column<0>()[n - 1]) << ")\n";
+    mgk::out.flush();
+}
+
+void benchBucketArray()
+{
+    const size_t n = 1 << 24;
+    mgk::out << "=== push_back of " << n << " uint64_t, then sum by index, ms ===\n";
+    mgk::out << "container | push_back | sum\n";
+
+    auto run = [n](const char* name, auto& c) {
+        uint64_t sum = 0;
+        uint64_t pushMs = timeMs([&] { for(uint64_t i = 0; i < n; ++i) c.push_back(i); });
+        uint64_t sumMs  = timeMs([&] { for(size_t i = 0; i < n; ++i) sum += c[i]; });
+        mgk::out << name << " | " << pushMs << " | " << sumMs << " (" << sum % 2 << ")\n";
+    };
+
+    mgk::BucketArray<uint64_t> buckets;
+    std::deque<uint64_t> deque;
+    mgk::Vector<uint64_t> vector;
+    run("BucketArray", buckets);
+    run("std::deque", deque);
+    run("mgk::Vector", vector);
+    mgk::out.flush();
+}
+
+void benchRingBuffer()
+{
+    const size_t n = 1 << 22, window = 4096;
+    mgk::out << "=== sliding window of " << window << " uint64_t, ns per element ===\n";
+
+    uint64_t sum = 0;
+    auto slide = [&sum, window](auto& container, auto popFront, size_t count) {
+        uint64_t ms = timeMs([&] {
+            for(uint64_t i = 0; i < count; ++i)
+            {
+                container.push_back(i);
+                if(container.size() > window) popFront(container);
+                sum += container[0];
+            }
+        });
+        return ms * 1000000 / count;
+    };
+
+    // Erase from front shifts whole window, so Vector gets fewer elements to keep run short.
+    mgk::Vector<uint64_t> vector;
+    std::deque<uint64_t> deque;
+    mgk::RingBuffer<uint64_t> ring;
+    uint64_t vectorNs = slide(vector, [](auto& v) { v.erase(v.begin()); }, n / 256);
+    uint64_t dequeNs  = slide(deque,  [](auto& d) { d.pop_front(); }, n);
+    uint64_t ringNs   = slide(ring,   [](auto& r) { r.pop_front(); }, n);
+
+    mgk::out << "Vector erase(begin) " << vectorNs << ", std::deque " << dequeNs << ", RingBuffer " << ringNs
+             << " (" << sum % 2 << ")\n";
+    mgk::out.flush();
+}
+
+}
+
+int main()
+{
+    benchRingBuffer();
+    benchBucketArray();
+    benchSoAVector();
+    benchVectorExpressions();
+    benchSimdAlgorithms();
+    benchAccessPolicy();
+    benchSmallVector();
+    benchVectorGrowth();
+    benchBatch();
+    benchThreadCaching();
+    benchConcurrentBucket();
+}
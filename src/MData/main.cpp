@@ -1,12 +1,34 @@
 #include "Allocator.hpp"
 #include "BitArray.hpp"
+#include "BucketArray.hpp"
 #include <bits/iterator_concepts.h>
+#include <cassert>
 #include <iostream>
 #include "MData/Pointers.hpp"
+#include "AllocatorConcepts.hpp"
+#include "ArenaAllocator.hpp"
+#include "AllocatorStats.hpp"
+#include "ConcurrentBucketAllocator.hpp"
+#include "MemoryResource.hpp"
+#include "RingBuffer.hpp"
+#include "SimdAlgorithms.hpp"
+#include "SlabAllocator.hpp"
+#include "SmallVector.hpp"
+#include "SoAVector.hpp"
+#include "ThreadCachingAllocator.hpp"
 #include "Vector.hpp"
+#include "VectorExpr.hpp"
+#include "VirtualVector.hpp"
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <deque>
 #include <list>
 #include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
 template<std::random_access_iterator Iter>
 void check(Iter)
@@ -19,8 +41,1224 @@ void kek(T t){
     t();
 }
 
+static void testThreadCachingAllocator()
+{
+    mgk::ThreadCachingAllocator<size_t, 16> alloc;
+    std::vector<size_t*> nodes;
+    for(size_t i = 0; i < 1000; ++i)
+    {
+        nodes.push_back(alloc.allocate());
+        *nodes.back() = i;
+    }
+
+    // Free on other thread. Nodes must come back to shared depot on thread exit.
+    std::thread([&nodes]{
+        mgk::ThreadCachingAllocator<size_t, 16> remote;
+        for(size_t i = 0; i < nodes.size(); ++i)
+        {
+            assert(*nodes[i] == i);
+            remote.deallocate(nodes[i]);
+        }
+    }).join();
+
+    // Remote thread filled far more magazines than depot keeps, excess went back to pool.
+    using Depot = mgk::MagazineDepot<size_t, 16>;
+    assert(Depot::instance().fullCount() <= Depot::MAX_FULL);
+
+    for(auto& node : nodes)
+    {
+        node = alloc.allocate();
+    }
+    std::sort(nodes.begin(), nodes.end());
+    assert(std::adjacent_find(nodes.begin(), nodes.end()) == nodes.end());
+
+    for(auto node : nodes)
+    {
+        alloc.deallocate(node);
+    }
+}
+
+static void testSlabAllocator()
+{
+    static_assert(mgk::Allocator<int, mgk::SlabAllocator>);
+
+    for(size_t bytes = 1; bytes <= mgk::SLAB_MAX_SIZE; ++bytes)
+    {
+        size_t cls = mgk::SlabHeap::sizeClass(bytes);
+        assert(mgk::SlabHeap::classSize(cls) >= bytes);
+        assert(cls == 0 || mgk::SlabHeap::classSize(cls - 1) < bytes);
+    }
+
+    mgk::SlabHeap heap;
+    mgk::Vector<size_t, mgk::SlabAllocator<size_t>> v{mgk::SlabAllocator<size_t>(heap)};
+    for(size_t i = 0; i < 10000; ++i)
+    {
+        v.push_back(i);
+    }
+    assert(v.size() == 10000);
+    for(size_t i = 0; i < v.size(); ++i)
+    {
+        assert(v[i] == i);
+    }
+
+    mgk::SlabAllocator<char> bytes(heap);
+    std::vector<std::pair<char*, size_t>> blocks;
+    for(size_t i = 1; i < 2 * mgk::SLAB_MAX_SIZE; i += 37)
+    {
+        blocks.emplace_back(bytes.allocate(i), i);
+        std::fill_n(blocks.back().first, i, static_cast<char>(i));
+    }
+    for(auto [block, size] : blocks)
+    {
+        assert(std::count(block, block + size, static_cast<char>(size)) == static_cast<ptrdiff_t>(size));
+        bytes.deallocate(block, size);
+    }
+
+    // Default allocators of all threads share one locked heap.
+    std::vector<std::thread> threads;
+    for(size_t t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([t]{
+            mgk::Vector<size_t, mgk::SlabAllocator<size_t>> local;
+            for(size_t i = 0; i < 10000; ++i) local.push_back(i * t);
+            for(size_t i = 0; i < local.size(); ++i) assert(local[i] == i * t);
+        });
+    }
+    for(auto& thread : threads) thread.join();
+}
+
+static void testArenaAllocator()
+{
+    static_assert(mgk::SingularAllocator<int, mgk::ArenaAllocator>);
+    static_assert(mgk::Allocator<int, mgk::ArenaAllocator>);
+    static_assert(mgk::AllocatorTraits<mgk::ArenaAllocator<int>>::is_monotonic);
+    static_assert(!mgk::AllocatorTraits<mgk::SlabAllocator<int>>::is_monotonic);
+
+    mgk::Arena arena(64);
+    mgk::ArenaAllocator<size_t> alloc(arena);
+    {
+        mgk::Vector<size_t, mgk::ArenaAllocator<size_t>> v(alloc);
+        for(size_t i = 0; i < 10000; ++i)
+        {
+            v.push_back(i);
+        }
+        assert(v[9999] == 9999);
+    }
+
+    auto checkpoint = arena.mark();
+    size_t* first = alloc.allocate();
+    *first = 1;
+    arena.rewind(checkpoint);
+    assert(alloc.allocate() == first);
+
+    struct alignas(64) Wide { char data[64]; };
+    mgk::ArenaAllocator<Wide> wide(alloc);
+    Wide* w = wide.allocate(3);
+    assert(reinterpret_cast<uintptr_t>(w) % 64 == 0);
+
+    arena.reset();
+}
+
+static void testConcurrentBucketAllocator()
+{
+    const size_t N_THREADS = 8;
+    const size_t N_ROUNDS  = 2000;
+    const size_t BATCH_SZ  = 64;
+
+    struct Node
+    {
+        size_t owner;
+        size_t index;
+    };
+
+    mgk::ConcurrentBucketAllocator<Node> alloc;
+    // Every thread hands half of its nodes to neighbour, so nodes are freed by other threads.
+    std::atomic<Node*> mailbox[N_THREADS] = {};
+
+    auto worker = [&](size_t id) {
+        Node* batch[BATCH_SZ] = {};
+        for(size_t round = 0; round < N_ROUNDS; ++round)
+        {
+            for(size_t i = 0; i < BATCH_SZ; ++i)
+            {
+                batch[i] = alloc.allocate();
+                *batch[i] = {id, i};
+            }
+            for(size_t i = 0; i < BATCH_SZ; ++i)
+            {
+                assert(batch[i]->owner == id && batch[i]->index == i);
+                if(i % 2)
+                {
+                    alloc.deallocate(mailbox[(id + 1) % N_THREADS].exchange(batch[i]));
+                }
+                else
+                {
+                    alloc.deallocate(batch[i]);
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(size_t id = 0; id < N_THREADS; ++id)
+    {
+        threads.emplace_back(worker, id);
+    }
+    for(auto& thread : threads)
+    {
+        thread.join();
+    }
+    for(auto& node : mailbox)
+    {
+        alloc.deallocate(node.exchange(nullptr));
+    }
+
+    std::vector<Node*> nodes;
+    for(size_t i = 0; i < 10000; ++i)
+    {
+        nodes.push_back(alloc.allocate());
+    }
+    std::sort(nodes.begin(), nodes.end());
+    assert(std::adjacent_find(nodes.begin(), nodes.end()) == nodes.end());
+}
+
+static void testBucketAllocatorReclaim()
+{
+    struct Node
+    {
+        size_t key;
+        Node*  next;
+    };
+
+    mgk::BucketAllocator<Node> alloc(2);
+    std::vector<Node*> nodes;
+    // More than old limit of 511 pages.
+    for(size_t i = 0; i < 600 * mgk::ALLOC_PAGE_SZ / sizeof(Node); ++i)
+    {
+        nodes.push_back(alloc.allocate());
+        nodes.back()->key = i;
+    }
+    assert(alloc.pageCount() > 600);
+
+    bool caught = false;
+    alloc.deallocate(nodes.back());
+    try { alloc.deallocate(nodes.back()); } catch(const std::runtime_error&) { caught = true; }
+    assert(caught);
+    nodes.pop_back();
+
+    for(size_t i = 0; i < nodes.size(); ++i)
+    {
+        assert(nodes[i]->key == i);
+        alloc.deallocate(nodes[i]);
+    }
+    assert(alloc.pageCount() == 2 && alloc.emptyPageCount() == 2);
+
+    alloc.setMaxEmptyPages(0);
+    assert(alloc.pageCount() == 0);
+}
+
+template<class Provider>
+static void testPageProvider(Provider provider)
+{
+    mgk::BucketAllocator<std::pair<size_t, size_t>, Provider> alloc(0, std::move(provider));
+    std::vector<std::pair<size_t, size_t>*> nodes;
+    for(size_t round = 0; round < 2; ++round)
+    {
+        for(size_t i = 0; i < 100000; ++i)
+        {
+            nodes.push_back(alloc.allocate());
+            *nodes.back() = {i, round};
+        }
+        for(size_t i = 0; i < nodes.size(); ++i)
+        {
+            assert(nodes[i]->first == i && nodes[i]->second == round);
+            alloc.deallocate(nodes[i]);
+        }
+        nodes.clear();
+        assert(alloc.pageCount() == 0);
+    }
+}
+
+namespace {
+    /// Counts providers set up from scratch rather than moved.
+    struct CountingPageProvider : mgk::NewPageProvider
+    {
+        static inline size_t created = 0;
+
+        CountingPageProvider() { ++created; }
+    };
+}
+
+static void testBucketAllocatorMove()
+{
+    mgk::BucketAllocator<uint64_t, CountingPageProvider> alloc;
+    uint64_t* node = alloc.allocate();
+    *node = 7;
+
+    size_t created = CountingPageProvider::created;
+    mgk::BucketAllocator<uint64_t, CountingPageProvider> moved(std::move(alloc));
+    assert(CountingPageProvider::created == created);
+    assert(moved.pageCount() == 1 && alloc.pageCount() == 0 && *node == 7);
+    moved.deallocate(node);
+}
+
+/// Hands out one value per call, like node allocators.
+template<class T>
+struct SingleAllocator
+{
+    using value_type = T;
+
+    T*   allocate()          { return mgk::DefaultDynamicAllocator<T>().allocate(); }
+    void deallocate(T* ptr)  { mgk::DefaultDynamicAllocator<T>().deallocate(ptr); }
+    bool operator==(const SingleAllocator&) const = default;
+};
+
+template<class T>
+using SingleStatsAllocator = mgk::StatsAllocator<T, SingleAllocator>;
+
+static void testAllocationStats()
+{
+    static_assert(mgk::Allocator<int, mgk::StatsAllocator>);
+    static_assert(mgk::SingularAllocator<int, SingleStatsAllocator>);
+    static_assert(!mgk::Allocator<int, SingleStatsAllocator>);
+
+    mgk::AllocationStats stats;
+    using Tracked = mgk::StatsAllocator<int, mgk::SlabAllocator>;
+    {
+        mgk::AllocTagScope tag("ints");
+        mgk::Vector<int, Tracked> v{Tracked(mgk::SlabAllocator<int>(), stats)};
+        for(int i = 0; i < 1000; ++i)
+        {
+            v.push_back(i);
+        }
+        assert(stats.total().liveBytes >= v.size() * sizeof(int));
+        assert(stats.tagUsage("ints").liveBytes == stats.total().liveBytes);
+    }
+    assert(stats.total().liveBytes == 0);
+    assert(stats.total().allocs == stats.total().deallocs);
+    assert(stats.tagUsage("ints").peakBytes >= 1000 * sizeof(int));
+    assert(stats.latencyPercentile(500) <= stats.latencyPercentile(999));
+
+    // Tag text is copied, so temporary names are fine.
+    std::string name = "temporary";
+    mgk::AllocationStats::Usage* temporary = &stats.tagUsage(name.c_str());
+    name = "overwritten";
+    assert(&stats.tagUsage("temporary") == temporary);
+    assert(&stats.tagUsage(name.c_str()) != temporary);
+
+    mgk::ofstream sink(static_cast<size_t>(0));
+    stats.report(sink);
+
+#ifdef MGK_ALLOC_STATS
+    static_assert(std::is_same_v<mgk::TrackedAllocator<int>, mgk::StatsAllocator<int>>);
+#else
+    static_assert(std::is_same_v<mgk::TrackedAllocator<int>, mgk::DefaultDynamicAllocator<int>>);
+#endif
+    MGK_ALLOC_TAG("tracked");
+    mgk::Vector<int, mgk::TrackedAllocator<int>> tracked(100, 1);
+}
+
+static void testMemoryResource()
+{
+    static_assert(mgk::Allocator<mgk::ResourceAllocator<int>, mgk::ResourceAllocator>);
+
+    mgk::Arena arena;
+    mgk::ArenaResource arenaResource(arena);
+    mgk::SlabResource  slabResource;
+    {
+        mgk::ScopedResource scope(arenaResource);
+        mgk::Vector<int, mgk::ResourceAllocator<int>> v;
+        for(int i = 0; i < 1000; ++i)
+        {
+            v.push_back(i);
+        }
+        assert(v.get_allocator().resource() == &arenaResource);
+        assert(arena.mark().block != nullptr);
+
+        {
+            mgk::ScopedResource inner(slabResource);
+            mgk::Vector<int, mgk::ResourceAllocator<int>> w(100, 7);
+            assert(w.get_allocator().resource() == &slabResource);
+            assert(w[99] == 7);
+        }
+        assert(mgk::getDefaultResource() == &arenaResource);
+
+        // Same container type, other resource chosen at run time.
+        mgk::Vector<int, mgk::ResourceAllocator<int>> u{mgk::ResourceAllocator<int>(&slabResource)};
+        u = v;
+        assert(u[999] == 999);
+    }
+    assert(mgk::getDefaultResource() == &mgk::NewDeleteResource::instance());
+
+    mgk::ResourceAllocator<double> alloc;
+    mgk::ResourceAllocator<char>   rebound(alloc);
+    assert(alloc.resource() == rebound.resource());
+    double* ptr = alloc.allocate(16);
+    ptr[15] = 1.0;
+    alloc.deallocate(ptr, 16);
+}
+
+template<class Alloc>
+static void testBatchAllocation(Alloc& alloc)
+{
+    const size_t n = 5000;
+    std::vector<size_t*> nodes(n);
+    alloc.allocate_n(n, nodes.data());
+    for(size_t i = 0; i < n; ++i)
+    {
+        *nodes[i] = i;
+    }
+    std::vector<size_t*> sorted = nodes;
+    std::sort(sorted.begin(), sorted.end());
+    assert(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+    for(size_t i = 0; i < n; ++i)
+    {
+        assert(*nodes[i] == i);
+    }
+
+    // Mix of batches and single frees, then everything is reused.
+    alloc.deallocate_batch(std::span<size_t* const>(nodes.data(), n / 2));
+    for(size_t i = n / 2; i < n; ++i)
+    {
+        alloc.deallocate(nodes[i]);
+    }
+    alloc.allocate_n(n, nodes.data());
+    alloc.deallocate_batch(nodes);
+}
+
+static void testBatchAllocators()
+{
+    static_assert(mgk::BatchAllocator<size_t, mgk::BucketAllocator>);
+    static_assert(mgk::BatchAllocator<size_t, mgk::ConcurrentBucketAllocator>);
+    static_assert(!mgk::BatchAllocator<size_t, mgk::DefaultDynamicAllocator>);
+
+    {
+        mgk::BucketAllocator<size_t> alloc(0);
+        testBatchAllocation(alloc);
+        assert(alloc.pageCount() == 0);
+    }
+    {
+        mgk::ConcurrentBucketAllocator<size_t> alloc;
+        testBatchAllocation(alloc);
+
+        std::vector<std::thread> threads;
+        for(size_t t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&alloc] {
+                size_t* batch[100];
+                for(size_t round = 0; round < 1000; ++round)
+                {
+                    alloc.allocate_n(100, batch);
+                    for(size_t* node : batch) *node = round;
+                    alloc.deallocate_batch(batch);
+                }
+            });
+        }
+        for(auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+}
+
+static void testStackAllocator()
+{
+    static_assert(mgk::Allocator<int, mgk::StackAllocator>);
+
+    mgk::FrameStack stack(1024);
+    for(size_t round = 0; round < 100; ++round)
+    {
+        mgk::FrameScope scope(stack);
+        mgk::Vector<int, mgk::StackAllocator<int>> scratch{mgk::StackAllocator<int>(stack)};
+        for(int i = 0; i < 500; ++i)
+        {
+            scratch.push_back(i);
+        }
+        assert(scratch[499] == 499);
+        assert(stack.overflowed());
+    }
+    assert(stack.used() == 0 && !stack.overflowed());
+
+    mgk::StackAllocator<char> bytes(stack);
+    mgk::StackAllocator<long double> wide(bytes);
+    auto marker = stack.mark();
+    long double* d = wide.allocate(2);
+    char* c = bytes.allocate(3);
+    assert(reinterpret_cast<uintptr_t>(d) % alignof(long double) == 0);
+    bytes.deallocate(c, 3);
+    wide.deallocate(d, 2);
+    assert(stack.used() == 0);
+
+    // Padding and frees out of order are kept till rewind, overflow blocks too.
+    c = bytes.allocate(3);
+    d = wide.allocate(1);
+    wide.deallocate(d, 1);
+    bytes.deallocate(c, 3);
+    c = bytes.allocate(16);
+    d = wide.allocate(1000);
+    bytes.deallocate(c, 16);
+    assert(stack.used() != 0 && stack.overflowed());
+    stack.rewind(marker);
+    assert(stack.used() == 0 && !stack.overflowed());
+
+    // Allocations made before marker and freed after it, in buffer and in overflow block.
+    c = bytes.allocate(16);
+    d = wide.allocate(1000);
+    auto inner = stack.mark();
+    wide.deallocate(d, 1000);
+    bytes.deallocate(c, 16);
+    assert(stack.used() == 0 && !stack.overflowed());
+    d = wide.allocate(1000);
+    stack.rewind(inner);
+    assert(stack.used() == 0 && !stack.overflowed());
+
+    bool caught = false;
+    try { (void)stack.allocate(SIZE_MAX - 8); } catch(mgk::FrameStack::Error err) { caught = err == mgk::FrameStack::Error::OutOfMemory; }
+    assert(caught && stack.used() == 0);
+}
+
+namespace {
+    /// Owns heap int. Relocatable, though move constructor is not trivial.
+    struct Boxed
+    {
+        static inline size_t moves = 0;
+
+        int* value;
+
+        explicit Boxed(int v) : value(new int(v)) {}
+        Boxed(const Boxed& oth) : value(new int(*oth.value)) {}
+        Boxed(Boxed&& oth) noexcept : value(oth.value) { oth.value = nullptr; moves++; }
+        Boxed& operator=(const Boxed&) = delete;
+        ~Boxed() { delete value; }
+    };
+
+    /// Owns heap int. Move may throw, so containers copy it and copy fails once copiesLeft runs out.
+    struct Fragile
+    {
+        static inline size_t copiesLeft = SIZE_MAX;
+
+        std::unique_ptr<int> value;
+
+        explicit Fragile(int v) : value(std::make_unique<int>(v)) {}
+        Fragile(const Fragile& oth) : value()
+        {
+            if(copiesLeft-- == 0) throw std::runtime_error("copy");
+            value = std::make_unique<int>(*oth.value);
+        }
+        Fragile(Fragile&& oth) : value(std::move(oth.value)) {}
+        Fragile& operator=(Fragile&&) = default;
+    };
+}
+
+template<>
+struct mgk::is_trivially_relocatable<Boxed> : std::true_type {};
+
+static void testVectorRelocation()
+{
+    static_assert(mgk::is_trivially_relocatable_v<uint64_t>);
+    static_assert(!mgk::is_trivially_relocatable_v<std::vector<int>>);
+
+    mgk::Vector<Boxed> boxes;
+    for(int i = 0; i < 1000; ++i)
+    {
+        boxes.push_back(Boxed(i));
+    }
+    assert(Boxed::moves == 1000); // One per push_back, none on growth.
+    for(int i = 0; i < 1000; ++i)
+    {
+        assert(*boxes[i].value == i);
+    }
+    mgk::Vector<Boxed> copy(boxes);
+    assert(*copy[999].value == 999 && copy[999].value != boxes[999].value);
+
+    mgk::Vector<std::vector<int>> nested;
+    for(int i = 0; i < 100; ++i)
+    {
+        nested.push_back(std::vector<int>(10, i));
+    }
+    assert(nested[99][9] == 99);
+
+    // Failed copy on growth frees new buffer and leaves elements in place.
+    mgk::Vector<Fragile> fragile;
+    fragile.reserve(4);
+    for(int i = 0; i < 4; ++i) fragile.emplace_back(i);
+    for(size_t copies : {0, 2})
+    {
+        Fragile::copiesLeft = copies;
+        bool caught = false;
+        try { fragile.emplace_back(4); } catch(const std::runtime_error&) { caught = true; }
+        assert(caught && fragile.size() == 4 && fragile.capacity() == 4);
+
+        Fragile::copiesLeft = copies;
+        caught = false;
+        try { fragile.insert(fragile.begin() + 2, fragile.begin(), fragile.begin() + 1); } catch(const std::runtime_error&) { caught = true; }
+        assert(caught && fragile.size() == 4);
+    }
+    Fragile::copiesLeft = SIZE_MAX;
+    fragile.reserve(100);
+    assert(fragile.size() == 4 && *fragile[3].value == 3);
+
+    mgk::Vector<uint64_t> zeros(1000, 0);
+    mgk::Vector<uint64_t> sevens(1000, 7);
+    mgk::Vector<char>     chars(1000, 'x');
+    assert(zeros[999] == 0 && sevens[999] == 7 && chars[999] == 'x');
+    zeros = sevens;
+    zeros = zeros;
+    assert(zeros.size() == 1000 && zeros[500] == 7);
+}
+
+template<template<typename> class Alloc>
+static void testVectorReallocate()
+{
+    static_assert(mgk::ReallocatingAllocator<uint64_t, Alloc>);
+
+    mgk::Vector<uint64_t, Alloc<uint64_t>> v;
+    for(uint64_t i = 0; i < 1'000'000; ++i)
+    {
+        v.push_back(i);
+    }
+    for(uint64_t i = 0; i < 1'000'000; i += 997)
+    {
+        assert(v[i] == i);
+    }
+
+    mgk::Vector<uint64_t, Alloc<uint64_t>> copy(v);
+    assert(copy.size() == v.size() && copy[999'999] == 999'999);
+
+    // Not relocatable values go through allocate and move.
+    mgk::Vector<std::vector<int>, Alloc<std::vector<int>>> nested;
+    for(int i = 0; i < 100; ++i)
+    {
+        nested.push_back(std::vector<int>(3, i));
+    }
+    assert(nested[99][2] == 99);
+}
+
+static void testStatsReallocate()
+{
+    using Tracked = mgk::StatsAllocator<int, mgk::Mallocator>;
+    static_assert(mgk::ReallocatingAllocator<int, mgk::Mallocator>);
+    static_assert(!mgk::ReallocatingAllocator<int, mgk::DefaultDynamicAllocator>);
+
+    mgk::AllocationStats stats;
+    {
+        mgk::Vector<int, Tracked> v{Tracked(mgk::Mallocator<int>(), stats)};
+        for(int i = 0; i < 1000; ++i)
+        {
+            v.push_back(i);
+        }
+        assert(stats.total().liveBytes >= 1000 * sizeof(int));
+    }
+    assert(stats.total().liveBytes == 0);
+}
+
+static void testVirtualVector()
+{
+    mgk::VirtualVector<uint64_t> v;
+    assert(v.max_size() == mgk::VirtualVector<uint64_t>::DEFAULT_RESERVE / sizeof(uint64_t));
+
+    v.push_back(0);
+    const uint64_t* first = &v[0];
+    for(uint64_t i = 1; i < 1'000'000; ++i)
+    {
+        v.push_back(i);
+    }
+    assert(&v[0] == first);
+    assert(v[999'999] == 999'999);
+    assert(std::is_sorted(v.begin(), v.end()));
+
+    v.resize(10);
+    v.decommit();
+    assert(v.capacity() * sizeof(uint64_t) < 2 * 4096 * 16);
+    assert(v[9] == 9 && &v[0] == first);
+    v.resize(100'000, 7);
+    assert(v[99'999] == 7);
+
+    mgk::VirtualVector<std::vector<int>> nested(1000);
+    nested.assign(1000, std::vector<int>(5, 1));
+    assert(nested.max_size() >= 1000);
+    nested.resize(nested.max_size(), std::vector<int>(5, 1));
+    try
+    {
+        nested.push_back({});
+        assert(!"Reserve exceeded");
+    }
+    catch(mgk::VirtualVector<std::vector<int>>::Error err)
+    {
+        assert(err == mgk::VirtualVector<std::vector<int>>::Error::OutOfMemory);
+    }
+
+    mgk::VirtualVector<std::vector<int>> copy(nested);
+    mgk::VirtualVector<std::vector<int>> moved(std::move(copy));
+    assert(moved.size() == nested.size() && moved[999][4] == 1 && copy.empty());
+    assert(copy.validate() && copy.max_size() == 0 && copy.data() == nullptr);
+}
+
+static void testSmallVector()
+{
+    mgk::SmallVector<int, 8> small;
+    for(int i = 0; i < 8; ++i)
+    {
+        small.push_back(i);
+    }
+    assert(small.isInline() && small.capacity() == 8);
+
+    mgk::SmallVector<int, 8> inlineMoved(std::move(small));
+    assert(inlineMoved.isInline() && inlineMoved[7] == 7 && small.empty());
+
+    for(int i = 8; i < 100; ++i)
+    {
+        inlineMoved.push_back(i);
+    }
+    assert(!inlineMoved.isInline());
+    const int* heap = &inlineMoved[0];
+    mgk::SmallVector<int, 8> spilledMoved(std::move(inlineMoved));
+    assert(&spilledMoved[0] == heap && inlineMoved.isInline());
+    assert(std::is_sorted(spilledMoved.begin(), spilledMoved.end()));
+
+    spilledMoved.push_back(spilledMoved[0]);
+    assert(spilledMoved[100] == 0);
+
+    mgk::SmallVector<std::vector<int>, 2> nested(3, std::vector<int>(4, 2));
+    mgk::SmallVector<std::vector<int>, 2> other;
+    other.push_back(std::vector<int>(1, 5));
+    nested.swap(other);
+    assert(nested.size() == 1 && nested[0][0] == 5);
+    assert(other.size() == 3 && other[2][3] == 2);
+    other.resize(1);
+    nested = other;
+    assert(nested.size() == 1 && nested[0].size() == 4);
+
+    mgk::SmallVector<Fragile, 2> fragile;
+    fragile.push_back(Fragile(0));
+    fragile.push_back(Fragile(1));
+    Fragile::copiesLeft = 1;
+    bool caught = false;
+    try { fragile.reserve(3); } catch(const std::runtime_error&) { caught = true; }
+    Fragile::copiesLeft = SIZE_MAX;
+    assert(caught && fragile.isInline() && *fragile[1].value == 1);
+}
+
+static void testVectorInsertion()
+{
+    mgk::Vector<std::unique_ptr<int>> owners;
+    for(int i = 0; i < 100; ++i)
+    {
+        owners.push_back(std::make_unique<int>(i));
+    }
+    owners.emplace_back(new int(100));
+    assert(*owners[100] == 100);
+    owners.pop_back();
+    assert(owners.size() == 100);
+
+    mgk::Vector<int> v;
+    for(int i = 0; i < 10; ++i)
+    {
+        v.emplace_back(i);
+    }
+    v.push_back(v[0]); // Argument refers to vector which reallocates.
+    assert(v[10] == 0);
+
+    std::list<int> extra = {100, 101, 102};
+    v.insert(v.begin() + 5, extra.begin(), extra.end());
+    assert(v.size() == 14 && v[4] == 4 && v[5] == 100 && v[7] == 102 && v[8] == 5);
+
+    v.erase(v.begin() + 5, v.begin() + 8);
+    assert(v.size() == 11 && v[5] == 5);
+
+    v.insert(v.begin(), v.begin(), v.end());
+    assert(v.size() == 22 && v[0] == 0 && v[10] == 0 && v[11] == 0 && v[21] == 0 && v[12] == 1);
+
+    std::vector<int> tail(100, 7);
+    v.append(tail);
+    assert(v.size() == 122 && v[121] == 7);
+
+    // Range given by raw pointers into vector, with room for it so nothing is reallocated.
+    v.reserve(v.size() + 3);
+    v.insert(v.begin(), v.data() + 1, v.data() + 4);
+    assert(v.size() == 125 && v[0] == 1 && v[2] == 3 && v[3] == 0 && v[4] == 1);
+
+    mgk::Vector<std::string> words;
+    std::vector<std::string> source = {"alpha", "beta", "gamma"};
+    words.append(std::move(source));
+    assert(words.size() == 3 && words[2] == "gamma" && source[2].empty());
+    words.insert(words.begin() + 1, source.begin(), source.begin() + 2);
+    words.erase(words.begin() + 1, words.begin() + 3);
+    assert(words.size() == 3 && words[1] == "beta");
+    words.insert(words.begin(), words.begin(), words.end());
+    assert(words.size() == 6 && words[3] == "alpha" && words[5] == "gamma");
+    words.erase(words.begin());
+    assert(words[0] == "beta");
+    words.reserve(words.size() + 2);
+    words.insert(words.begin(), words.data(), words.data() + 2);
+    assert(words.size() == 7 && words[0] == "beta" && words[1] == "gamma" && words[2] == "beta");
+
+    std::istringstream numbers("1 2 3");
+    mgk::Vector<int> parsed(2, 0);
+    parsed.insert(parsed.begin() + 1, std::istream_iterator<int>(numbers), std::istream_iterator<int>());
+    assert(parsed.size() == 5 && parsed[0] == 0 && parsed[1] == 1 && parsed[3] == 3 && parsed[4] == 0);
+}
+
+static void testVectorAccessPolicy()
+{
+    using Unchecked = mgk::Vector<int, mgk::DefaultDynamicAllocator<int>, mgk::UncheckedAccess>;
+    using Checked   = mgk::Vector<int, mgk::DefaultDynamicAllocator<int>, mgk::CheckedAccess>;
+    static_assert(std::contiguous_iterator<Unchecked::iterator>);
+    static_assert(std::contiguous_iterator<Unchecked::const_iterator>);
+    static_assert(std::random_access_iterator<Checked::iterator>);
+    static_assert(std::is_same_v<mgk::Vector<int>, Checked>);
+
+    Unchecked v;
+    for(int i = 0; i < 1000; ++i)
+    {
+        v.push_back((i * 7919) % 1000);
+    }
+    std::sort(v.begin(), v.end());
+    assert(v.data() == &*v.begin());
+    for(int i = 0; i < 1000; ++i)
+    {
+        assert(v[i] == i);
+    }
+    assert(std::find(v.begin(), v.end(), 500) - v.begin() == 500);
+
+    v.erase(v.begin() + 10, v.end());
+    v.insert(v.begin(), v.begin() + 5, v.end());
+    assert(v.size() == 15 && v[0] == 5 && v[5] == 0);
+
+    const Unchecked& cv = v;
+    assert(*(cv.end() - 1) == 9);
+
+    Checked c(3, 1);
+    try
+    {
+        c[3] = 0;
+        assert(!"Index is checked");
+    }
+    catch(Checked::Error err)
+    {
+        assert(err == Checked::Error::OutOfRange);
+    }
+}
+
+static void testVectorGrowth()
+{
+    using Slab = mgk::SlabAllocator<uint32_t>;
+    mgk::Vector<uint32_t, Slab, mgk::DefaultAccess, mgk::SizeClassGrowth> classes;
+    for(uint32_t i = 0; i < 10'000; ++i)
+    {
+        classes.push_back(i);
+        size_t bytes = classes.capacity() * sizeof(uint32_t);
+        assert(bytes > mgk::SLAB_MAX_SIZE || bytes == mgk::SlabHeap::goodSize(bytes));
+        assert(bytes <= mgk::SLAB_MAX_SIZE || bytes % mgk::OS_PAGE_SZ == 0);
+    }
+
+    mgk::Vector<int, mgk::DefaultDynamicAllocator<int>, mgk::DefaultAccess, mgk::HalfGrowth> half;
+    size_t prev = 0;
+    for(int i = 0; i < 1000; ++i)
+    {
+        half.push_back(i);
+        if(half.capacity() != prev && prev > 10) assert(half.capacity() == prev + prev / 2 + 1);
+        prev = half.capacity();
+    }
+
+    using Step = mgk::StepGrowth<1024>;
+    mgk::Vector<uint64_t, mgk::DefaultDynamicAllocator<uint64_t>, mgk::DefaultAccess, Step> step;
+    for(uint64_t i = 0; i < 1000; ++i)
+    {
+        step.push_back(i);
+    }
+    assert(step.capacity() % 128 == 0 && step.capacity() - step.size() < 128);
+
+    mgk::Vector<std::string> words(100, "word");
+    words.reserve(1000);
+    words.erase(words.begin() + 10, words.end());
+    words.shrink_to_fit();
+    assert(words.capacity() == 10 && words[9] == "word");
+    words.clean();
+    words.shrink_to_fit();
+    assert(words.capacity() == 0 && words.validate());
+
+    mgk::Vector<int, mgk::Mallocator<int>> ints(1000, 1);
+    ints.resize(3);
+    ints.shrink_to_fit();
+    assert(ints.capacity() == 3 && ints[2] == 1);
+}
+
+// Test values are chosen so that results are exact, floats are compared exactly on purpose.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+
+template<class T>
+static void checkSimdAlgorithms(size_t n)
+{
+    mgk::Vector<T> a, b;
+    for(size_t i = 0; i < n; ++i)
+    {
+        // Small integer values keep float sums exact whatever the order of additions.
+        a.push_back(static_cast<T>((i * 37 + 11) % 61));
+        b.push_back(static_cast<T>((i * 13 + 5) % 7));
+    }
+    const T* begin = a.data();
+    const T* end   = a.data() + n;
+
+    for(T key : {T(0), T(11), T(60), T(100)})
+    {
+        assert(mgk::simd::find(a, key) == static_cast<size_t>(std::find(begin, end, key) - begin));
+        assert(mgk::simd::count(a, key) == static_cast<size_t>(std::count(begin, end, key)));
+    }
+
+    auto bounds = mgk::simd::minmax(a);
+    assert(bounds.has_value() == (n != 0));
+    if(n)
+    {
+        assert(bounds->first  == *std::min_element(begin, end) && *mgk::simd::min(a) == bounds->first);
+        assert(bounds->second == *std::max_element(begin, end) && *mgk::simd::max(a) == bounds->second);
+    }
+
+    using Sum = decltype(mgk::simd::sum(a));
+    Sum sum = 0, dot = 0;
+    for(size_t i = 0; i < n; ++i)
+    {
+        sum += static_cast<Sum>(a[i]);
+        dot += static_cast<Sum>(a[i]) * static_cast<Sum>(b[i]);
+    }
+    assert(mgk::simd::sum(a) == sum);
+    assert(mgk::simd::dot(a, b) == dot);
+}
+
+template<class T>
+static void checkSimdAlgorithms()
+{
+    for(size_t n = 0; n < 300; n += 7) checkSimdAlgorithms<T>(n);
+    checkSimdAlgorithms<T>(70'000);
+
+    // Narrow lane counters must not overflow on long runs of matches.
+    mgk::Vector<T> same(100'000, T(3));
+    assert(mgk::simd::count(same, T(3)) == same.size());
+    assert(mgk::simd::find(same, T(4)) == same.size());
+}
+
+static void testSimdAlgorithms()
+{
+    const mgk::simd::Isa best = mgk::simd::activeIsa();
+    for(auto isa : {mgk::simd::Isa::Scalar, mgk::simd::Isa::Avx2, mgk::simd::Isa::Avx512})
+    {
+        if(mgk::simd::setIsa(isa) != isa) continue;
+
+        checkSimdAlgorithms<int8_t>();
+        checkSimdAlgorithms<uint8_t>();
+        checkSimdAlgorithms<int16_t>();
+        checkSimdAlgorithms<uint32_t>();
+        checkSimdAlgorithms<int32_t>();
+        checkSimdAlgorithms<int64_t>();
+        checkSimdAlgorithms<float>();
+        checkSimdAlgorithms<double>();
+
+        // NaN inside first vector but not first element is skipped like anywhere else.
+        mgk::Vector<float> nan(32, 0.0f);
+        nan[1]  = NAN;
+        nan[17] = -100;
+        nan[20] = 5;
+        auto bounds = mgk::simd::minmax(nan);
+        assert(bounds && bounds->first == -100 && bounds->second == 5);
+        assert(*mgk::simd::min(nan) == -100 && *mgk::simd::max(nan) == 5);
+    }
+    mgk::simd::setIsa(best);
+
+    mgk::Vector<int> empty;
+    assert(!mgk::simd::min(empty) && !mgk::simd::max(empty) && !mgk::simd::minmax(empty) && mgk::simd::sum(empty) == 0);
+
+    mgk::SmallVector<float, 4> small(3, 1.5f);
+    assert(mgk::simd::sum(small) == 4.5f && mgk::simd::find(small, 1.5f) == 0);
+}
+
+#pragma GCC diagnostic pop
+
+// Every element is computed by same operations as expected value, so results match exactly.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+
+static void testVectorExpressions()
+{
+    const size_t n = 100'000;
+    mgk::Vector<double> a, b, c;
+    for(size_t i = 0; i < n; ++i)
+    {
+        a.push_back(static_cast<double>(i));
+        b.push_back(static_cast<double>(i % 7));
+        c.push_back(0.5);
+    }
+
+    static_assert(mgk::VectorExpression<decltype(a + b), double>);
+    static_assert(!mgk::VectorExpression<mgk::Vector<double>, double>);
+
+    mgk::Vector<double> r = a + b * c - 2;
+    assert(r.size() == n);
+    for(size_t i = 0; i < n; ++i)
+    {
+        assert(r[i] == a[i] + b[i] * c[i] - 2);
+    }
+
+    // Assignment of same size reuses buffer, operands may alias result.
+    const double* buffer = r.data();
+    r = -(r * 2.0) + 1 / c;
+    assert(r.data() == buffer);
+    for(size_t i = 0; i < n; ++i)
+    {
+        assert(r[i] == -((a[i] + b[i] * c[i] - 2) * 2.0) + 1 / c[i]);
+    }
+
+    mgk::Vector<double> serial = (a - b) * (a + b) / 3;
+    mgk::Vector<double> parallel;
+    parallel = mgk::parallel((a - b) * (a + b) / 3, 4);
+    assert(parallel.size() == n);
+    assert(std::equal(serial.data(), serial.data() + n, parallel.data()));
+
+    mgk::Vector<float> f(3, 1.5f);
+    mgk::Vector<float> g = f * 2 + f;
+    static_assert(std::is_same_v<decltype(f * 2)::value_type, float>);
+    assert(g.size() == 3 && g[2] == 4.5f);
+
+    mgk::Vector<int> ints(5, 7);
+    mgk::Vector<double> mixed = ints / 2 + 0.25;
+    assert(mixed[4] == 3.25);
+
+    bool caught = false;
+    try { mgk::Vector<double> bad = a + f * 2; } catch(mgk::ExprCommon::Error err) { caught = err == mgk::ExprCommon::Error::OutOfRange; }
+    assert(caught);
+}
+
+#pragma GCC diagnostic pop
+
+// Stored floats are read back unchanged.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+
+static void testSoAVector()
+{
+    mgk::SoAVector<int, double, std::string> rows;
+    for(int i = 0; i < 1000; ++i)
+    {
+        rows.push_back(i, i * 0.5, std::to_string(i));
+    }
+    assert(rows.size() == 1000 && rows.capacity() >= 1000 && rows.validate());
+
+    std::span<int> ids = rows.column<0>();
+    assert(ids.size() == 1000 && ids[999] == 999);
+
+    auto [id, weight, name] = rows[10];
+    assert(id == 10 && weight == 5.0 && name == "10");
+    weight = -1;
+    rows[11] = decltype(rows)::value_type{110, 55.0, "eleven"};
+    assert(rows.column<1>()[10] == -1 && std::get<2>(rows[11]) == "eleven");
+
+    // Row which refers to container itself while it grows.
+    rows.shrink_to_fit();
+    assert(rows.capacity() == 1000);
+    rows.push_back(rows[11]);
+    assert(std::get<0>(rows[1000]) == 110 && std::get<2>(rows[1000]) == "eleven");
+
+    mgk::SoAVector<int, double, std::string> copy = rows;
+    rows.pop_back();
+    assert(copy.size() == 1001 && rows.size() == 1000 && std::get<2>(copy[1000]) == "eleven");
+
+    size_t visited = 0;
+    for(auto [i, w, s] : copy)
+    {
+        assert(s == (visited == 11 || visited == 1000 ? "eleven" : std::to_string(i)));
+        ++visited;
+    }
+    assert(visited == copy.size() && copy.end() - copy.begin() == 1001);
+
+    mgk::SoAVector<float, float> points(10);
+    assert(points.column<0>()[9] == 0.0f && points.column<1>()[9] == 0.0f);
+
+    bool caught = false;
+    try { points[10]; } catch(decltype(points)::Error err) { caught = err == decltype(points)::Error::OutOfRange; }
+    assert(caught);
+
+    // Column which may throw is copied before others are moved, so failed growth keeps all rows.
+    mgk::SoAVector<std::string, Fragile> fragile;
+    for(int i = 0; i < 3; ++i) fragile.push_back(std::to_string(i), Fragile(i));
+    Fragile::copiesLeft = 1;
+    caught = false;
+    try { fragile.reserve(100); } catch(const std::runtime_error&) { caught = true; }
+    Fragile::copiesLeft = SIZE_MAX;
+    assert(caught && fragile.column<0>()[2] == "2" && *fragile.column<1>()[2].value == 2);
+    fragile.reserve(100);
+    assert(fragile.capacity() == 100 && fragile.column<0>()[2] == "2" && *fragile.column<1>()[2].value == 2);
+}
+
+#pragma GCC diagnostic pop
+
+static void testBucketArray()
+{
+    using Array = mgk::BucketArray<std::string, 256>;
+    static_assert(Array::BLOCK_SZ == 256 / sizeof(std::string));
+
+    Array arr;
+    std::deque<std::string> ref;
+    std::vector<const std::string*> addresses;
+    for(int i = 0; i < 5000; ++i)
+    {
+        std::string value = std::to_string(i);
+        if(i % 3 == 0)
+        {
+            arr.push_front(value);
+            ref.push_front(value);
+            addresses.push_back(&arr.front());
+        }
+        else
+        {
+            arr.push_back(value);
+            ref.push_back(value);
+            addresses.push_back(&arr.back());
+        }
+    }
+    assert(arr.size() == ref.size() && arr.validate());
+    assert(std::equal(arr.begin(), arr.end(), ref.begin(), ref.end()));
+
+    // Growth never moves elements.
+    for(int i = 0; i < 5000; ++i)
+    {
+        assert(*addresses[i] == std::to_string(i));
+    }
+
+    for(int i = 0; i < 4000; ++i)
+    {
+        if(i % 2) { arr.pop_front(); ref.pop_front(); }
+        else      { arr.pop_back();  ref.pop_back(); }
+    }
+    assert(std::equal(arr.begin(), arr.end(), ref.begin(), ref.end()));
+    assert(arr.blockCount() <= ref.size() / Array::BLOCK_SZ + 2);
+
+    Array copy = arr;
+    arr.clean();
+    assert(arr.empty() && arr.blockCount() == 0 && copy.size() == ref.size() && copy[0] == ref[0]);
+
+    // Pushes and pops at block border reuse spare block.
+    mgk::BucketArray<int, 64> border;
+    for(int i = 0; i < 100; ++i)
+    {
+        border.push_back(i);
+        border.pop_front();
+    }
+    assert(border.empty());
+
+    bool caught = false;
+    try { border.pop_back(); } catch(mgk::BucketArray<int, 64>::Error err) { caught = err == mgk::BucketArray<int, 64>::Error::OutOfRange; }
+    assert(caught);
+}
+
+template<class Ring, class Ref>
+static void checkRing(const Ring& ring, const Ref& ref)
+{
+    assert(ring.validate() && ring.size() == ref.size());
+    assert(std::equal(ring.begin(), ring.end(), ref.begin(), ref.end()));
+
+    auto [first, second] = ring.two_spans();
+    assert(first.size() + second.size() == ref.size());
+    assert(std::equal(first.begin(), first.end(), ref.begin()));
+    assert(std::equal(second.begin(), second.end(), ref.begin() + static_cast<ptrdiff_t>(first.size())));
+}
+
+static void testRingBuffer()
+{
+    mgk::RingBuffer<std::string> ring;
+    std::deque<std::string> ref;
+    for(int i = 0; i < 20000; ++i)
+    {
+        std::string value = std::to_string(i);
+        switch(rand() % 5)
+        {
+            case 0: ring.push_front(value); ref.push_front(value); break;
+            case 1: ring.push_back(value);  ref.push_back(value);  break;
+            case 2: if(!ref.empty()) { ring.pop_front(); ref.pop_front(); } break;
+            case 3: if(!ref.empty()) { ring.pop_back();  ref.pop_back();  } break;
+            default:
+                // Argument refers to element which moves during growth.
+                if(!ref.empty()) { ring.push_back(ring.front()); ref.push_back(ref.front()); }
+        }
+    }
+    checkRing(ring, ref);
+
+    size_t consumed = ring.two_spans().first.size();
+    ring.pop_front_n(consumed);
+    ref.erase(ref.begin(), ref.begin() + static_cast<ptrdiff_t>(consumed));
+    checkRing(ring, ref);
+
+    mgk::RingBuffer<std::string> copy = ring;
+    ring.clean();
+    assert(ring.empty() && ring.capacity() != 0);
+    checkRing(copy, ref);
+
+    // Wrapped buffers grown in place by reallocate(): short tail run moves, then long one.
+    for(int wrapped : {3, 13})
+    {
+        mgk::RingBuffer<int, mgk::Mallocator<int>> ints;
+        std::deque<int> intRef;
+        for(int i = 0; i < 16; ++i) { ints.push_back(i); intRef.push_back(i); }
+        for(int i = 0; i < wrapped; ++i)
+        {
+            ints.pop_front(); intRef.pop_front();
+            ints.push_back(100 + i); intRef.push_back(100 + i);
+        }
+        ints.reserve(40);
+        assert(ints.capacity() == 64);
+        checkRing(ints, intRef);
+        ints.push_front(-1); intRef.push_front(-1);
+        checkRing(ints, intRef);
+    }
+
+    bool caught = false;
+    try { ring.pop_front(); } catch(mgk::RingBuffer<std::string>::Error err) { caught = err == mgk::RingBuffer<std::string>::Error::OutOfRange; }
+    assert(caught);
+
+    // Copy failing in second run on growth leaves wrapped ring as it was.
+    mgk::RingBuffer<Fragile> fragile;
+    for(int i = 0; i < 4; ++i)
+    {
+        fragile.emplace_back(i);
+        fragile.emplace_front(-1 - i);
+    }
+    Fragile::copiesLeft = 5;
+    caught = false;
+    try { fragile.emplace_back(4); } catch(const std::runtime_error&) { caught = true; }
+    Fragile::copiesLeft = SIZE_MAX;
+    assert(caught && fragile.size() == 8 && *fragile.front().value == -4 && *fragile.back().value == 3);
+}
+
 int main()
 {
+    testRingBuffer();
+    testBucketArray();
+    testSoAVector();
+    testVectorExpressions();
+    testSimdAlgorithms();
+    testVectorGrowth();
+    testVectorAccessPolicy();
+    testVectorInsertion();
+    testSmallVector();
+    testVirtualVector();
+    testVectorReallocate<mgk::Mallocator>();
+    testVectorReallocate<mgk::MmapAllocator>();
+    testStatsReallocate();
+    testVectorRelocation();
+    testStackAllocator();
+    testBatchAllocators();
+    testMemoryResource();
+    testAllocationStats();
+    testPageProvider(mgk::NewPageProvider());
+    testPageProvider(mgk::MmapPageProvider());
+    testPageProvider(mgk::HugePageProvider());
+    testPageProvider(mgk::ReservedPageProvider(64 * mgk::ALLOC_PAGE_SZ + 1));
+    testBucketAllocatorReclaim();
+    testBucketAllocatorMove();
+    testConcurrentBucketAllocator();
+    testArenaAllocator();
+    testSlabAllocator();
+    testThreadCachingAllocator();
+
     mgk::BitArray v(10, 0);
     v[0] = true;
     v[1] = true;
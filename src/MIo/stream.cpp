@@ -38,6 +38,7 @@ namespace mgk {
         if(!buffer_)
         {
             write(&c, 1);
+            return;
         }
 
         if(bufferSize_ == bufferCapacity_)
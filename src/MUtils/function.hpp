@@ -1,5 +1,6 @@
 #ifndef MUTILS_FUNCTION_HPP
 #define MUTILS_FUNCTION_HPP
+#include <utility>
 #include <MUtils/utils.hpp>
 namespace mgk {
 
@@ -49,8 +50,8 @@ public:
     UniqueFunction& operator=(const UniqueFunction& oth) = delete;
 
 // Movalble
-    UniqueFunction(UniqueFunction&& oth)            { std::swap(callable_, oth.callable_); }
-    UniqueFunction& operator=(UniqueFunction&& oth) { std::swap(callable_, oth.callable_); }
+    UniqueFunction(UniqueFunction&& oth) noexcept            { std::swap(callable_, oth.callable_); }
+    UniqueFunction& operator=(UniqueFunction&& oth) noexcept { std::swap(callable_, oth.callable_); return *this; }
 
 
     template<class FuncT>
@@ -1,6 +1,10 @@
 #ifndef MUTILS_UTILS_HPP
 #define MUTILS_UTILS_HPP
+#include <cstddef>
+#include <cstring>
+#include <new>
 #include <type_traits>
+#include <utility>
 namespace mgk {
 
     template<class T> 
@@ -37,6 +41,70 @@ namespace mgk {
 	  "my::forward must not be used to convert an rvalue to an lvalue");
         return static_cast<T&&>(a);
     }
+
+    /**
+     * @brief Object of T may be moved to other address by copying its bytes, after which source is treated as
+     * destroyed. Automatic for trivially copyable types, other types opt in by specializing this trait.
+     */
+    template<class T>
+    struct is_trivially_relocatable : std::bool_constant<std::is_trivially_copyable<T>::value> {};
+
+    template<class T>
+    inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+    /// Pair is relocatable by bytes when both members are.
+    template<class A, class B>
+    struct is_trivially_relocatable<std::pair<A, B>>
+        : std::bool_constant<is_trivially_relocatable_v<A> && is_trivially_relocatable_v<B>> {};
+
+    namespace detail {
+
+        /**
+         * @brief Constructs n objects at uninitialized dst from src, moving them if that cannot throw and copying
+         * otherwise. On exception constructed objects are destroyed and copied src is left intact.
+         */
+        template<class T>
+        void uninitialized_move_if_noexcept(T* dst, T* src, std::size_t n)
+        {
+            std::size_t i = 0;
+            try
+            {
+                for(; i < n; ++i) new(&dst[i]) T(std::move_if_noexcept(src[i]));
+            }
+            catch(...)
+            {
+                for(std::size_t j = 0; j < i; ++j) dst[j].~T();
+                throw;
+            }
+        }
+
+        /**
+         * @brief Moves n objects from src to uninitialized dst, src objects end up destroyed. Ranges may overlap only
+         * for trivially relocatable T. On exception dst holds nothing and src is unchanged, unless T is neither
+         * nothrow movable nor copyable.
+         */
+        template<class T>
+        void relocate(T* dst, T* src, std::size_t n)
+        {
+            if constexpr (is_trivially_relocatable_v<T>)
+            {
+                if(n) std::memmove(static_cast<void*>(dst), static_cast<const void*>(src), n * sizeof(T));
+            }
+            else if constexpr (std::is_nothrow_move_constructible_v<T>)
+            {
+                for(std::size_t i = 0; i < n; ++i)
+                {
+                    new(&dst[i]) T(std::move(src[i]));
+                    src[i].~T();
+                }
+            }
+            else
+            {
+                uninitialized_move_if_noexcept(dst, src, n);
+                for(std::size_t i = 0; i < n; ++i) src[i].~T();
+            }
+        }
+    }
     
 } // namespace mgk
 #endif /* MUTILS_UTILS_HPP */